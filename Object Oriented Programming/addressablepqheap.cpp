@@ -0,0 +1,179 @@
+/*
+ * This file, addressablepqheap, holds the test cases for the AddressablePQHeap class template defined in
+ * addressablepqheap.h, and a time trial of a rescheduling workload against PQHeap with stale entries.
+ */
+#include "addressablepqheap.h"
+#include "pqheap.h"
+#include "random.h"
+#include "strlib.h"
+#include "SimpleTest.h"
+using namespace std;
+
+template class AddressablePQHeap<DataPoint>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("AddressablePQHeap: handles find their element through changePriority and remove") {
+    AddressablePQHeap<DataPoint> pq;
+    Vector<AddressablePQHeap<DataPoint>::Handle> handles;
+    for (DataPoint pt : Vector<DataPoint>{ {"A", 5}, {"B", 3}, {"C", 8}, {"D", 1}, {"E", 6}, {"F", 4} }) {
+        handles.add(pq.enqueue(pt));
+        pq.debugConfirmInternalArray();
+    }
+    EXPECT_EQUAL(pq.size(), 6);
+    EXPECT_EQUAL(pq.get(handles[2]), {"C", 8});
+
+    pq.changePriority(handles[2], 0);       // C jumps to the front
+    pq.debugConfirmInternalArray();
+    EXPECT_EQUAL(pq.peek(), {"C", 0});
+
+    pq.changePriority(handles[2], 10);      // and sinks to the back
+    pq.debugConfirmInternalArray();
+    EXPECT_EQUAL(pq.peek(), {"D", 1});
+
+    pq.update(handles[3], {"D2", 7});
+    pq.debugConfirmInternalArray();
+    EXPECT_EQUAL(pq.get(handles[3]), {"D2", 7});
+
+    EXPECT_EQUAL(pq.remove(handles[4]), {"E", 6});
+    pq.debugConfirmInternalArray();
+    EXPECT(!pq.contains(handles[4]));
+    EXPECT_ERROR(pq.remove(handles[4]));
+    EXPECT_ERROR(pq.changePriority(handles[4], 2));
+
+    Vector<string> order;
+    while (!pq.isEmpty()) {
+        order.add(pq.dequeue().label);
+        pq.debugConfirmInternalArray();
+    }
+    EXPECT_EQUAL(order, {"B", "F", "A", "D2", "C"});
+    for (auto handle : handles) {
+        EXPECT(!pq.contains(handle));
+    }
+}
+
+STUDENT_TEST("AddressablePQHeap: stale handles stay invalid after their slot is reused") {
+    AddressablePQHeap<DataPoint> pq;
+    auto first = pq.enqueue({"first", 1});
+    pq.dequeue();
+    auto second = pq.enqueue({"second", 2});     // reuses first's slot
+    EXPECT_EQUAL(first.slot, second.slot);
+    EXPECT(!pq.contains(first));
+    EXPECT(pq.contains(second));
+    EXPECT_ERROR(pq.get(first));
+
+    pq.clear();
+    EXPECT(!pq.contains(second));
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+    EXPECT(!pq.contains(AddressablePQHeap<DataPoint>::Handle()));
+}
+
+STUDENT_TEST("AddressablePQHeap: random enqueue/changePriority/remove/dequeue against a model") {
+    setRandomSeed(12);
+    AddressablePQHeap<DataPoint> pq;
+    Vector<AddressablePQHeap<DataPoint>::Handle> live;
+    Vector<DataPoint> model;
+
+    for (int step = 0; step < 20000; step++) {
+        int op = randomInteger(0, 3);
+        if (op == 0 || model.isEmpty()) {
+            DataPoint pt = { integerToString(step), double(randomInteger(0, 500)) };
+            live.add(pq.enqueue(pt));
+            model.add(pt);
+        } else if (op == 1) {
+            int i = randomInteger(0, model.size() - 1);
+            model[i].priority = randomInteger(0, 500);
+            pq.changePriority(live[i], model[i].priority);
+        } else if (op == 2) {
+            int i = randomInteger(0, model.size() - 1);
+            DataPoint removed = pq.remove(live[i]);
+            EXPECT_EQUAL(removed, model[i]);
+            live.remove(i);
+            model.remove(i);
+        } else {
+            double lowest = model[0].priority;
+            for (const DataPoint& pt : model) {
+                lowest = min(lowest, pt.priority);
+            }
+            DataPoint front = pq.dequeue();
+            EXPECT_EQUAL(front.priority, lowest);
+            int i = 0;
+            while (model[i].label != front.label) i++;
+            live.remove(i);
+            model.remove(i);
+        }
+        EXPECT_EQUAL(pq.size(), model.size());
+        if (step % 64 == 0) {
+            pq.debugConfirmInternalArray();
+        }
+    }
+    for (int i = 0; i < model.size(); i++) {
+        EXPECT_EQUAL(pq.get(live[i]), model[i]);
+    }
+}
+
+/* Rescheduling workload: numJobs jobs are queued, then each of numUpdates steps moves a random
+ * job to a new time, and finally every job is run in order. Returns the labels in run order.
+ * The PQHeap version enqueues a fresh entry on every move and skips stale ones when they
+ * surface, which is what the scheduler has had to do; peakSize reports how big its heap got.
+ */
+static Vector<string> rescheduleWithStaleEntries(int numJobs, int numUpdates, int& peakSize) {
+    PQHeap pq;
+    Vector<double> current(numJobs);
+    for (int job = 0; job < numJobs; job++) {
+        current[job] = randomReal(0, 1);
+        pq.enqueue({ integerToString(job), current[job] });
+    }
+    peakSize = pq.size();
+    for (int step = 0; step < numUpdates; step++) {
+        int job = randomInteger(0, numJobs - 1);
+        current[job] = randomReal(0, 1);
+        pq.enqueue({ integerToString(job), current[job] });
+        peakSize = max(peakSize, pq.size());
+    }
+
+    Vector<string> order;
+    while (!pq.isEmpty()) {
+        DataPoint pt = pq.dequeue();
+        if (pt.priority == current[stringToInteger(pt.label)]) {
+            order.add(pt.label);
+        }
+    }
+    return order;
+}
+
+static Vector<string> rescheduleWithHandles(int numJobs, int numUpdates, int& peakSize) {
+    AddressablePQHeap<DataPoint> pq;
+    Vector<AddressablePQHeap<DataPoint>::Handle> handles;
+    for (int job = 0; job < numJobs; job++) {
+        handles.add(pq.enqueue({ integerToString(job), randomReal(0, 1) }));
+    }
+    peakSize = pq.size();
+    for (int step = 0; step < numUpdates; step++) {
+        int job = randomInteger(0, numJobs - 1);
+        pq.changePriority(handles[job], randomReal(0, 1));
+    }
+
+    Vector<string> order;
+    while (!pq.isEmpty()) {
+        order.add(pq.dequeue().label);
+    }
+    return order;
+}
+
+STUDENT_TEST("AddressablePQHeap: time rescheduling with changePriority vs PQHeap with stale entries") {
+    int numJobs = 100000;
+    for (int numUpdates = 200000; numUpdates <= 1600000; numUpdates *= 2) {
+        int stalePeak, handlePeak;
+        Vector<string> staleOrder, handleOrder;
+        setRandomSeed(numUpdates);
+        TIME_OPERATION(numUpdates, staleOrder = rescheduleWithStaleEntries(numJobs, numUpdates, stalePeak));
+        setRandomSeed(numUpdates);
+        TIME_OPERATION(numUpdates, handleOrder = rescheduleWithHandles(numJobs, numUpdates, handlePeak));
+        EXPECT_EQUAL(handleOrder, staleOrder);
+        EXPECT_EQUAL(handlePeak, numJobs);
+        EXPECT_EQUAL(stalePeak, numJobs + numUpdates);
+    }
+}
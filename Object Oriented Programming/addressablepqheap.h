@@ -0,0 +1,365 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include "strlib.h"
+#include <utility>
+#include <vector>
+
+/**
+ * Binary-heap priority queue whose elements can be found again after they are
+ * enqueued, so their priority can be changed or they can be removed while they
+ * are still in the queue.
+ *
+ * enqueue returns a Handle naming the new element. Internally every handle owns
+ * a slot that records where its element currently sits in the heap array; each
+ * move made while percolating writes the new index back to the slot, so a
+ * handle always leads straight to its element. That bookkeeping makes every
+ * move a little more expensive than in BasicPQHeap, which is why this is a
+ * separate class rather than a feature of PQHeap.
+ *
+ * A handle stays valid until its element leaves the queue (through dequeue,
+ * remove or clear). Slots are reused afterwards, but each reuse bumps a
+ * generation counter stored in both the slot and the handle, so a stale handle
+ * is detected instead of silently naming a newer element.
+ *
+ * T and Compare are as for BasicPQHeap: compare(a, b) returns true when a
+ * should be dequeued before b.
+ */
+template <typename T, typename Compare = LowerPriorityFirst>
+class AddressablePQHeap {
+public:
+    /**
+     * Names one element of the queue. Default-constructed handles name nothing.
+     */
+    struct Handle {
+        int slot = -1;
+        unsigned generation = 0;
+    };
+
+    /**
+     * Creates a new, empty priority queue that orders elements using compare.
+     */
+    explicit AddressablePQHeap(Compare compare = Compare());
+
+    /**
+     * Adds a new element into the queue and returns a handle to it. This
+     * operation runs in time O(log n).
+     */
+    Handle enqueue(const T& element);
+    Handle enqueue(T&& element);
+
+    /**
+     * Removes and returns the frontmost element. Its handle becomes invalid.
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     */
+    T dequeue();
+
+    /**
+     * Returns, but does not remove, the frontmost element. If the priority
+     * queue is empty, this function calls error().
+     */
+    const T& peek() const;
+
+    /**
+     * Returns whether handle names an element that is still in the queue.
+     */
+    bool contains(Handle handle) const;
+
+    /**
+     * Returns the element named by handle. If the handle is not valid, this
+     * function calls error().
+     */
+    const T& get(Handle handle) const;
+
+    /**
+     * Replaces the element named by handle with element and moves it up or down
+     * to its new place. The handle stays valid. If the handle is not valid,
+     * this function calls error().
+     *
+     * This operation runs in time O(log n).
+     */
+    void update(Handle handle, T element);
+
+    /**
+     * Sets the priority member of the element named by handle and moves it to
+     * its new place; a shorthand for update() when T has a priority member, as
+     * DataPoint does. Works for both decreases and increases. If the handle is
+     * not valid, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     */
+    void changePriority(Handle handle, double priority);
+
+    /**
+     * Removes the element named by handle from the queue, wherever it is, and
+     * returns it. The handle becomes invalid. If the handle is not valid, this
+     * function calls error().
+     *
+     * This operation runs in time O(log n).
+     */
+    T remove(Handle handle);
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue. Every handle becomes invalid.
+     */
+    void clear();
+
+    /*
+     * Confirms that the internal array obeys the heap order and that every
+     * live slot points at the entry that names it. Raises an error if a
+     * problem is found. Intended solely for testing.
+     */
+    void debugConfirmInternalArray() const;
+
+private:
+    static const int NONE = -1;     // position of a slot with no element
+
+    /* An element in the heap array, with the slot of the handle that names it. */
+    struct Entry {
+        T element;
+        int slot;
+    };
+
+    /* Where a handle's element is, and which use of the slot the handle belongs to. */
+    struct Slot {
+        int position;
+        unsigned generation;
+    };
+
+    int positionOf(Handle handle) const; // index of handle's element, calling error() if the handle is stale
+    int allocateSlot(); // takes a slot from the free list or adds a new one
+    void releaseSlot(int slot); // marks slot empty and invalidates its handles
+    void fill(int hole, Entry&& entry); // moves entry into the hole and records its new position
+    void percolateUp(int hole, Entry&& entry); // moves the hole up past less urgent parents, then fills it
+    void percolateDown(int hole, Entry&& entry); // moves the hole down past more urgent children, then fills it
+    void reseat(int hole, Entry&& entry); // fills the hole with entry, percolating whichever way it needs
+    Handle place(T&& element); // appends element in a fresh slot and percolates it up
+
+    std::vector<Entry> _entries;    // the heap, in the usual array layout
+    std::vector<Slot> _slots;       // indexed by Handle::slot
+    std::vector<int> _freeSlots;    // slots with no element, ready for reuse
+    Compare _compare;               // compare(a, b) is true when a is more urgent than b
+
+    DISALLOW_COPYING_OF(AddressablePQHeap);
+};
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+template <typename T, typename Compare>
+AddressablePQHeap<T, Compare>::AddressablePQHeap(Compare compare) : _compare(std::move(compare)) {
+}
+
+template <typename T, typename Compare>
+typename AddressablePQHeap<T, Compare>::Handle AddressablePQHeap<T, Compare>::enqueue(const T& element) {
+    return place(T(element));
+}
+
+template <typename T, typename Compare>
+typename AddressablePQHeap<T, Compare>::Handle AddressablePQHeap<T, Compare>::enqueue(T&& element) {
+    return place(std::move(element));
+}
+
+/*
+ * The new element's slot is allocated first so that the entry already knows which slot to keep
+ * up to date as it percolates up from the end of the array.
+ */
+template <typename T, typename Compare>
+typename AddressablePQHeap<T, Compare>::Handle AddressablePQHeap<T, Compare>::place(T&& element) {
+    int slot = allocateSlot();
+    _entries.emplace_back();
+    percolateUp(size() - 1, Entry{ std::move(element), slot });
+    return Handle{ slot, _slots[slot].generation };
+}
+
+template <typename T, typename Compare>
+T AddressablePQHeap<T, Compare>::dequeue() {
+    if (isEmpty()) {
+        error("Cannot dequeue because AddressablePQHeap is empty!");
+    }
+    return remove(Handle{ _entries[0].slot, _slots[_entries[0].slot].generation });
+}
+
+template <typename T, typename Compare>
+const T& AddressablePQHeap<T, Compare>::peek() const {
+    if (isEmpty()) {
+        error("Cannot peek because AddressablePQHeap is empty!");
+    }
+    return _entries[0].element;
+}
+
+template <typename T, typename Compare>
+bool AddressablePQHeap<T, Compare>::contains(Handle handle) const {
+    return handle.slot >= 0 && handle.slot < int(_slots.size())
+        && _slots[handle.slot].generation == handle.generation
+        && _slots[handle.slot].position != NONE;
+}
+
+template <typename T, typename Compare>
+const T& AddressablePQHeap<T, Compare>::get(Handle handle) const {
+    return _entries[positionOf(handle)].element;
+}
+
+/*
+ * The entry is taken out of its place, which leaves a hole there, and reseat decides which way it has to go.
+ */
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::update(Handle handle, T element) {
+    int position = positionOf(handle);
+    reseat(position, Entry{ std::move(element), handle.slot });
+}
+
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::changePriority(Handle handle, double priority) {
+    int position = positionOf(handle);
+    Entry entry = std::move(_entries[position]);
+    entry.element.priority = priority;
+    reseat(position, std::move(entry));
+}
+
+/*
+ * Removing from the middle works like dequeue: the last entry is taken out to fill the hole. Unlike at the
+ * root, the last entry may be more urgent than the removed element's parent, so it can need to go up.
+ */
+template <typename T, typename Compare>
+T AddressablePQHeap<T, Compare>::remove(Handle handle) {
+    int position = positionOf(handle);
+    T removed = std::move(_entries[position].element);
+    releaseSlot(handle.slot);
+
+    Entry last = std::move(_entries.back());
+    _entries.pop_back();
+    if (position < size()) {
+        reseat(position, std::move(last));
+    }
+    return removed;
+}
+
+template <typename T, typename Compare>
+bool AddressablePQHeap<T, Compare>::isEmpty() const {
+    return _entries.empty();
+}
+
+template <typename T, typename Compare>
+int AddressablePQHeap<T, Compare>::size() const {
+    return int(_entries.size());
+}
+
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::clear() {
+    for (const Entry& entry : _entries) {
+        releaseSlot(entry.slot);
+    }
+    _entries.clear();
+}
+
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::debugConfirmInternalArray() const {
+    for (int i = 0; i < size(); i++) {
+        if (i > 0 && _compare(_entries[i].element, _entries[(i - 1) / 2].element)) {
+            error("AddressablePQHeap has an element more urgent than its parent at index " + integerToString(i));
+        }
+        if (_slots[_entries[i].slot].position != i) {
+            error("AddressablePQHeap slot does not point back at index " + integerToString(i));
+        }
+    }
+    if (int(_slots.size() - _freeSlots.size()) != size()) {
+        error("AddressablePQHeap has slots that are neither live nor free");
+    }
+}
+
+template <typename T, typename Compare>
+int AddressablePQHeap<T, Compare>::positionOf(Handle handle) const {
+    if (!contains(handle)) {
+        error("AddressablePQHeap handle does not name an element in the queue!");
+    }
+    return _slots[handle.slot].position;
+}
+
+template <typename T, typename Compare>
+int AddressablePQHeap<T, Compare>::allocateSlot() {
+    if (_freeSlots.empty()) {
+        _slots.push_back(Slot{ NONE, 0 });
+        return int(_slots.size()) - 1;
+    }
+    int slot = _freeSlots.back();
+    _freeSlots.pop_back();
+    return slot;
+}
+
+/*
+ * Bumping the generation here, rather than on allocation, means handles to the released element stop
+ * being valid immediately, not just once the slot is reused.
+ */
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::releaseSlot(int slot) {
+    _slots[slot].position = NONE;
+    _slots[slot].generation++;
+    _freeSlots.push_back(slot);
+}
+
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::fill(int hole, Entry&& entry) {
+    _slots[entry.slot].position = hole;
+    _entries[hole] = std::move(entry);
+}
+
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::percolateUp(int hole, Entry&& entry) {
+    while (hole > 0) {
+        int parent = (hole - 1) / 2;
+        if (!_compare(entry.element, _entries[parent].element)) {
+            break;
+        }
+        fill(hole, std::move(_entries[parent]));
+        hole = parent;
+    }
+    fill(hole, std::move(entry));
+}
+
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::percolateDown(int hole, Entry&& entry) {
+    int count = size();
+    while (true) {
+        int child = 2 * hole + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && _compare(_entries[child + 1].element, _entries[child].element)) {
+            child++;
+        }
+        if (!_compare(_entries[child].element, entry.element)) {
+            break;
+        }
+        fill(hole, std::move(_entries[child]));
+        hole = child;
+    }
+    fill(hole, std::move(entry));
+}
+
+/*
+ * An entry that belongs further up than the hole can never also belong further down, so one comparison
+ * with the parent picks the direction.
+ */
+template <typename T, typename Compare>
+void AddressablePQHeap<T, Compare>::reseat(int hole, Entry&& entry) {
+    if (hole > 0 && _compare(entry.element, _entries[(hole - 1) / 2].element)) {
+        percolateUp(hole, std::move(entry));
+    } else {
+        percolateDown(hole, std::move(entry));
+    }
+}
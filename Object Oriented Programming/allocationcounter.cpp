@@ -0,0 +1,86 @@
+/*
+ * This file, allocationcounter, replaces the global operator new and operator delete so that benchmarks
+ * can count allocations. The replacements live in their own file so that no other code is compiled
+ * alongside them: the compiler would otherwise inline them into that code and warn that memory from new
+ * is handed to free. They are only compiled when COUNT_ALLOCATIONS is defined, so the application build
+ * keeps the standard allocator.
+ */
+#include "allocationcounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+using namespace std;
+
+#ifdef COUNT_ALLOCATIONS
+
+static atomic<long> numAllocations(0);
+
+long allocationCount() {
+    return numAllocations.load();
+}
+
+bool countingAllocations() {
+    return true;
+}
+
+/* The array and nothrow forms of new call this one by default, so replacing it counts them too. */
+void* operator new(size_t size) {
+    numAllocations++;
+    if (void* block = malloc(size == 0 ? 1 : size)) {
+        return block;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+
+/* Over-aligned types go through the aligned forms, which do not fall back on the plain new above.
+ * aligned_alloc wants a size that is a multiple of the alignment; Windows has no aligned_alloc, and
+ * memory from its _aligned_malloc must go back through _aligned_free. */
+void* operator new(size_t size, align_val_t alignment) {
+    numAllocations++;
+    size_t align = size_t(alignment);
+    size_t rounded = (size == 0 ? align : (size + align - 1) / align * align);
+#ifdef _WIN32
+    void* block = _aligned_malloc(rounded, align);
+#else
+    void* block = aligned_alloc(align, rounded);
+#endif
+    if (block) {
+        return block;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* block, align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+void operator delete(void* block, size_t, align_val_t alignment) noexcept {
+    operator delete(block, alignment);
+}
+
+#else
+
+long allocationCount() {
+    return 0;
+}
+
+bool countingAllocations() {
+    return false;
+}
+
+#endif
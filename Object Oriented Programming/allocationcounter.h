@@ -0,0 +1,22 @@
+#pragma once
+
+/**
+ * Returns how many times the global operator new has been called since the
+ * program started. Benchmarks take the difference of two calls to report how
+ * many allocations an operation costs.
+ *
+ * The count comes from replacements of the global operator new and delete in
+ * allocationcounter.cpp, so it covers every allocation in the program,
+ * including those inside std::string and the Stanford collections. Because
+ * that puts an atomic increment on every allocation Qt and the library make
+ * too, the replacements are only compiled into benchmark builds, which define
+ * COUNT_ALLOCATIONS (add CONFIG += count_allocations in PQueue.pro). In any
+ * other build this function always returns 0.
+ */
+long allocationCount();
+
+/**
+ * Returns whether this build counts allocations, i.e. whether it was compiled
+ * with COUNT_ALLOCATIONS.
+ */
+bool countingAllocations();
@@ -0,0 +1,263 @@
+/*
+ * This file, arenapqheap, implements the ArenaPQHeap class declared in arenapqheap.h, followed by its test
+ * cases and a time trial against PQHeap that also reports how many allocations each operation costs
+ * (counted by allocationcounter, in builds configured with count_allocations).
+ */
+#include "arenapqheap.h"
+#include "allocationcounter.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "SimpleTest.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+using namespace std;
+
+ArenaPQHeap::ArenaPQHeap() : _deadBytes(0) {}
+
+string_view ArenaPQHeap::labelOf(const Entry& entry) const {
+    return string_view(_arena.data() + entry.offset, entry.length);
+}
+
+void ArenaPQHeap::enqueue(const DataPoint& element) {
+    enqueue(element.label, element.priority);
+}
+
+/*
+ * The label is appended to the arena before the entry that points at it goes into the heap. A label
+ * that is itself a view into the arena, such as one from peekLabel, would dangle as soon as growing the
+ * arena reallocated it, so that one is copied by offset once the room has been made.
+ */
+void ArenaPQHeap::enqueue(string_view label, double priority) {
+    if (_arena.size() + label.size() > numeric_limits<uint32_t>::max()) {
+        error("ArenaPQHeap label arena cannot grow past 4 GiB!");
+    }
+    uint32_t offset = uint32_t(_arena.size());
+    const char* arenaBegin = _arena.data();
+    const char* arenaEnd = arenaBegin + _arena.size();
+    if (!label.empty() && !less<const char*>()(label.data(), arenaBegin) && less<const char*>()(label.data(), arenaEnd)) {
+        size_t from = size_t(label.data() - arenaBegin);
+        _arena.resize(_arena.size() + label.size());
+        copy_n(_arena.begin() + from, label.size(), _arena.begin() + offset);
+    } else {
+        _arena.insert(_arena.end(), label.begin(), label.end());
+    }
+    _entries.enqueue({ priority, offset, uint32_t(label.size()) });
+}
+
+DataPoint ArenaPQHeap::dequeue() {
+    DataPoint result;
+    dequeueInto(result);
+    return result;
+}
+
+/*
+ * The label is copied out before reclaim gets a chance to reset or compact the arena under it.
+ */
+void ArenaPQHeap::dequeueInto(DataPoint& result) {
+    if (isEmpty()) {
+        error("Cannot dequeue because ArenaPQHeap is empty!");
+    }
+    Entry front = _entries.dequeue();
+    string_view label = labelOf(front);
+    result.label.assign(label.data(), label.size());
+    result.priority = front.priority;
+
+    _deadBytes += front.length;
+    reclaim();
+}
+
+string_view ArenaPQHeap::peekLabel() const {
+    if (isEmpty()) {
+        error("Cannot peek because ArenaPQHeap is empty!");
+    }
+    return labelOf(_entries.peek());
+}
+
+double ArenaPQHeap::peekPriority() const {
+    if (isEmpty()) {
+        error("Cannot peek because ArenaPQHeap is empty!");
+    }
+    return _entries.peek().priority;
+}
+
+bool ArenaPQHeap::isEmpty() const {
+    return _entries.isEmpty();
+}
+
+int ArenaPQHeap::size() const {
+    return _entries.size();
+}
+
+/*
+ * Entries have no destructor and labels are just bytes in the arena, so dropping every element is two
+ * size resets, however many labels there were.
+ */
+void ArenaPQHeap::clear() {
+    _entries.clear();
+    _arena.clear();
+    _deadBytes = 0;
+}
+
+int64_t ArenaPQHeap::arenaBytes() const {
+    return int64_t(_arena.size());
+}
+
+/*
+ * An empty queue simply starts the arena over. Otherwise, once the dead bytes outnumber the live ones,
+ * the live entries are taken out (in sorted order, which is already a valid heap), their labels copied
+ * into a fresh arena and the entries put back with one heapify. Taking the entries out costs
+ * O(n log n), but at least as many bytes have been dequeued since the last compaction as are copied, so
+ * the cost spread over those dequeues is no more than the dequeues themselves took.
+ */
+void ArenaPQHeap::reclaim() {
+    if (isEmpty()) {
+        _arena.clear();
+        _deadBytes = 0;
+        return;
+    }
+    int64_t liveBytes = arenaBytes() - _deadBytes;
+    if (_deadBytes < MIN_COMPACT_BYTES || _deadBytes <= liveBytes) {
+        return;
+    }
+
+    vector<Entry> live(size());
+    _entries.dequeueMany(size(), live.data());
+
+    vector<char> compacted;
+    compacted.reserve(size_t(liveBytes));
+    for (Entry& entry : live) {
+        uint32_t offset = uint32_t(compacted.size());
+        compacted.insert(compacted.end(), _arena.begin() + entry.offset, _arena.begin() + entry.offset + entry.length);
+        entry.offset = offset;
+    }
+    _arena.swap(compacted);
+    _deadBytes = 0;
+    _entries.enqueueAll(std::move(live));
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("ArenaPQHeap: dequeues in priority order with labels intact") {
+    ArenaPQHeap pq;
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peekLabel());
+
+    Vector<DataPoint> input = {
+        {"R", 4}, {"A", 5}, {"a label well past the small-string limit", 3}, {"K", 7}, {"", 2},
+        {"V", 9}, {"T", 1}, {"O", 8}, {"S", 6} };
+    for (const DataPoint& dp : input) {
+        pq.enqueue(dp);
+    }
+    EXPECT_EQUAL(pq.size(), 9);
+    EXPECT_EQUAL(string(pq.peekLabel()), "T");
+    EXPECT_EQUAL(pq.peekPriority(), 1);
+
+    EXPECT_EQUAL(pq.dequeue(), {"T", 1});
+    EXPECT_EQUAL(pq.dequeue(), {"", 2});
+    DataPoint reused = {"previous contents", 0};
+    pq.dequeueInto(reused);
+    EXPECT_EQUAL(reused, {"a label well past the small-string limit", 3});
+    for (int priority = 4; priority <= 9; priority++) {
+        EXPECT_EQUAL(pq.dequeue().priority, priority);
+    }
+    EXPECT(pq.isEmpty());
+    EXPECT_EQUAL(pq.arenaBytes(), 0);                       // released when the queue ran empty
+}
+
+STUDENT_TEST("ArenaPQHeap: enqueueing a label viewed from the queue itself survives the arena growing") {
+    ArenaPQHeap pq;
+    pq.enqueue("a label well past the small-string limit", 0);
+    for (int i = 1; i <= 2000; i++) {
+        pq.enqueue(pq.peekLabel(), i);
+    }
+    EXPECT_EQUAL(pq.size(), 2001);
+    while (!pq.isEmpty()) {
+        EXPECT_EQUAL(pq.dequeue().label, "a label well past the small-string limit");
+    }
+}
+
+STUDENT_TEST("ArenaPQHeap: clear releases every label at once") {
+    ArenaPQHeap pq;
+    for (int i = 0; i < 1000; i++) {
+        pq.enqueue("label number " + integerToString(i), i);
+    }
+    EXPECT(pq.arenaBytes() > 1000);
+    pq.clear();
+    EXPECT(pq.isEmpty());
+    EXPECT_EQUAL(pq.arenaBytes(), 0);
+    pq.enqueue({"after", 1});
+    EXPECT_EQUAL(pq.dequeue(), {"after", 1});
+}
+
+STUDENT_TEST("ArenaPQHeap: stays bounded and matches PQHeap when the queue never empties") {
+    setRandomSeed(19);
+    ArenaPQHeap pq;
+    PQHeap reference;
+    int64_t largestArena = 0;
+    for (int i = 0; i < 200000; i++) {
+        if (reference.size() < 100 || randomChance(0.5)) {
+            int priority = randomInteger(0, 1000);
+            DataPoint elem = {"element with priority " + integerToString(priority), double(priority)};
+            reference.enqueue(elem);
+            pq.enqueue(elem);
+        } else {
+            DataPoint expected = reference.dequeue();
+            DataPoint actual = pq.dequeue();
+            EXPECT_EQUAL(actual.priority, expected.priority);
+            EXPECT_EQUAL(actual.label, "element with priority " + integerToString(int(actual.priority)));
+        }
+        largestArena = max(largestArena, pq.arenaBytes());
+    }
+    EXPECT_EQUAL(pq.size(), reference.size());
+    EXPECT(largestArena < 4 * (1 << 16));                   // compacted over and over instead of growing
+}
+
+/* Copies every point in and drains the queue into one reused DataPoint, as a consumer loop would. */
+template <typename Queue>
+static void fillAndDrain(Queue& pq, const Vector<DataPoint>& input, long& enqueueAllocations, long& dequeueAllocations) {
+    long before = allocationCount();
+    for (const DataPoint& pt : input) {
+        pq.enqueue(pt);
+    }
+    long filled = allocationCount();
+
+    DataPoint cur;
+    while (!pq.isEmpty()) {
+        if constexpr (is_same<Queue, ArenaPQHeap>::value) {
+            pq.dequeueInto(cur);
+        } else {
+            cur = pq.dequeue();
+        }
+    }
+    enqueueAllocations = filled - before;
+    dequeueAllocations = allocationCount() - filled;
+}
+
+STUDENT_TEST("ArenaPQHeap: time and count allocations against PQHeap with long labels") {
+    for (int n = 100000; n <= 1000000; n *= 10) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"a label of some thirty characters " + integerToString(i % 100), randomReal(0, 10)});
+        }
+        long enqueued, dequeued;
+        PQHeap heap;
+        ArenaPQHeap arena;
+
+        TIME_OPERATION(n, fillAndDrain(heap, input, enqueued, dequeued));
+        if (countingAllocations()) {
+            cout << "    PQHeap: " << double(enqueued) / n << " allocations per enqueue, "
+                 << double(dequeued) / n << " per dequeue" << endl;
+        }
+        TIME_OPERATION(n, fillAndDrain(arena, input, enqueued, dequeued));
+        if (countingAllocations()) {
+            cout << "    ArenaPQHeap: " << double(enqueued) / n << " allocations per enqueue, "
+                 << double(dequeued) / n << " per dequeue" << endl;
+        }
+    }
+}
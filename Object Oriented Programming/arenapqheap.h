@@ -0,0 +1,106 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "pqheap.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * Priority queue of DataPoints that keeps every label in one arena owned by
+ * the queue instead of in a std::string per element.
+ *
+ * The heap itself holds compact 16-byte entries: the priority plus the offset
+ * and length of the label's bytes in the arena. Enqueueing appends the label
+ * to the arena, so a label longer than the small-string limit costs no
+ * allocation of its own (the arena grows geometrically, like a Vector), and
+ * percolation only ever moves the small entries around.
+ *
+ * Dequeued labels are not freed one at a time. The whole arena is released in
+ * one step when the queue is cleared or runs empty, and when dequeued labels
+ * come to outweigh the live ones the live labels are compacted into a fresh
+ * arena, so a queue that never empties still holds at most about twice the
+ * bytes it needs.
+ *
+ * dequeueInto reuses the caller's DataPoint, so a consumer that drains the
+ * queue into the same variable allocates nothing once its label has grown.
+ * Elements of equal priority are dequeued in arbitrary order, as for PQHeap.
+ */
+class ArenaPQHeap {
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    ArenaPQHeap();
+
+    /**
+     * Adds a new element, copying its label into the arena. If the arena
+     * would grow past 4 GiB, this function calls error(). This operation runs
+     * in time O(log n + length of the label).
+     */
+    void enqueue(const DataPoint& element);
+    void enqueue(std::string_view label, double priority);
+
+    /**
+     * Removes and returns the frontmost element. If the priority queue is
+     * empty, this function calls error().
+     */
+    DataPoint dequeue();
+
+    /**
+     * Removes the frontmost element and stores it in result, reusing the
+     * memory result's label already has. If the priority queue is empty, this
+     * function calls error().
+     */
+    void dequeueInto(DataPoint& result);
+
+    /**
+     * Returns the label and priority of the frontmost element without copying
+     * the label. The view is valid until the queue is next modified. If the
+     * priority queue is empty, this function calls error().
+     */
+    std::string_view peekLabel() const;
+    double peekPriority() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements and releases all their labels at once. The arena
+     * keeps its memory for reuse.
+     */
+    void clear();
+
+    /**
+     * Returns the number of label bytes in the arena, including those of
+     * elements already dequeued but not yet compacted away.
+     */
+    int64_t arenaBytes() const;
+
+private:
+    /* Compaction only pays off once the dead labels amount to at least this many bytes. */
+    static const int64_t MIN_COMPACT_BYTES = 1 << 16;
+
+    /* What the heap holds for each element: its label is _arena[offset, offset + length). */
+    struct Entry {
+        double priority;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    std::string_view labelOf(const Entry& entry) const;
+    void reclaim();     // empties or compacts the arena once enough of it is dead
+
+    BasicPQHeap<Entry> _entries;
+    std::vector<char> _arena;   // label bytes of every element enqueued since the last reset
+    int64_t _deadBytes;         // bytes in _arena that belong to dequeued elements
+
+    DISALLOW_COPYING_OF(ArenaPQHeap);
+};
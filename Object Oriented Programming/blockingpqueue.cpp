@@ -0,0 +1,136 @@
+/*
+ * This file, blockingpqueue, holds the test cases for the BlockingPQueue class template defined in
+ * blockingpqueue.h, and a time trial of single dequeues against batched ones in a pipeline.
+ */
+#include "blockingpqueue.h"
+#include "random.h"
+#include "strlib.h"
+#include "SimpleTest.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+using namespace std;
+
+template class BlockingPQueue<DataPoint>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("BlockingPQueue: single thread, priority order, batches and timeouts") {
+    BlockingPQueue<DataPoint> pq(4);
+    EXPECT_EQUAL(pq.capacity(), 4);
+    pq.enqueue({"c", 3});
+    pq.enqueue({"a", 1});
+    pq.enqueue({"d", 4});
+    EXPECT(pq.enqueueFor({"b", 2}, chrono::milliseconds(0)));
+    EXPECT_EQUAL(pq.size(), 4);
+
+    DataPoint extra = {"full", 0};
+    EXPECT(!pq.enqueueFor(std::move(extra), chrono::milliseconds(20)));    // full: times out
+    EXPECT_EQUAL(extra, {"full", 0});                                       // and leaves it alone
+
+    EXPECT_EQUAL(pq.dequeue(), {"a", 1});
+    Vector<DataPoint> batch = pq.dequeueBatch(2);
+    EXPECT_EQUAL(batch, { {"b", 2}, {"c", 3} });
+    batch = pq.dequeueBatch(10);
+    EXPECT_EQUAL(batch, { {"d", 4} });
+
+    DataPoint result;
+    EXPECT(!pq.dequeueFor(result, chrono::milliseconds(20)));              // empty: times out
+    EXPECT_ERROR(pq.dequeueBatch(0));
+    EXPECT_ERROR(BlockingPQueue<DataPoint>(0));
+}
+
+STUDENT_TEST("BlockingPQueue: close lets consumers drain, then stops them and producers") {
+    BlockingPQueue<DataPoint> pq(8);
+    pq.enqueue({"left over", 1});
+    pq.close();
+    EXPECT(pq.isClosed());
+    EXPECT_ERROR(pq.enqueue({"late", 2}));
+    EXPECT(!pq.enqueueFor({"late", 2}, chrono::milliseconds(0)));
+
+    EXPECT_EQUAL(pq.dequeue(), {"left over", 1});
+    EXPECT_ERROR(pq.dequeue());
+    DataPoint result;
+    EXPECT(!pq.dequeueFor(result, chrono::seconds(10)));      // returns at once, no waiting
+    EXPECT_EQUAL(pq.dequeueBatch(4).size(), 0);
+
+    /* A consumer already blocked on an empty queue is woken by close. */
+    BlockingPQueue<DataPoint> idle(8);
+    atomic<bool> woke(false);
+    thread consumer([&] {
+        idle.dequeueBatch(4);
+        woke = true;
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    idle.close();
+    consumer.join();
+    EXPECT(woke.load());
+}
+
+/* Runs numProducers threads that each enqueue perProducer points into a queue of the given capacity,
+ * and numConsumers threads that take them out batchSize at a time (1 means plain dequeue) until the
+ * queue is closed and drained. Returns how many times each point was received.
+ */
+static Vector<int> runPipeline(int capacity, int numProducers, int perProducer, int numConsumers, int batchSize) {
+    BlockingPQueue<DataPoint> pq(capacity);
+    int total = numProducers * perProducer;
+    vector<vector<int>> received(numConsumers);
+
+    vector<thread> producers, consumers;
+    for (int p = 0; p < numProducers; p++) {
+        producers.emplace_back([&pq, p, perProducer] {
+            for (int i = 0; i < perProducer; i++) {
+                int id = p * perProducer + i;
+                pq.enqueue({ to_string(id), double(id % 101) });
+            }
+        });
+    }
+    for (int c = 0; c < numConsumers; c++) {
+        consumers.emplace_back([&pq, &received, c, batchSize] {
+            if (batchSize == 1) {
+                DataPoint pt;
+                while (pq.dequeueFor(pt, chrono::hours(1))) {
+                    received[c].push_back(stoi(pt.label));
+                }
+            } else {
+                Vector<DataPoint> batch;
+                while (!(batch = pq.dequeueBatch(batchSize)).isEmpty()) {
+                    for (const DataPoint& pt : batch) {
+                        received[c].push_back(stoi(pt.label));
+                    }
+                }
+            }
+        });
+    }
+    for (thread& t : producers) {
+        t.join();
+    }
+    pq.close();
+    for (thread& t : consumers) {
+        t.join();
+    }
+
+    Vector<int> timesSeen(total, 0);
+    for (const vector<int>& ids : received) {
+        for (int id : ids) {
+            timesSeen[id]++;
+        }
+    }
+    return timesSeen;
+}
+
+STUDENT_TEST("BlockingPQueue: producers and consumers through a small queue lose nothing") {
+    for (int batchSize : { 1, 7, 64 }) {
+        Vector<int> timesSeen = runPipeline(16, 4, 5000, 3, batchSize);
+        EXPECT_EQUAL(timesSeen, Vector<int>(20000, 1));
+    }
+}
+
+STUDENT_TEST("BlockingPQueue: time a pipeline with single dequeues vs dequeueBatch") {
+    int perProducer = 250000;
+    for (int batchSize : { 1, 16, 256 }) {
+        TIME_OPERATION(batchSize, runPipeline(1024, 4, perProducer, 2, batchSize));
+    }
+}
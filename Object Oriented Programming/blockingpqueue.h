@@ -0,0 +1,253 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include "vector.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+/**
+ * Thread-safe, bounded priority queue for handing work from one pipeline
+ * stage to the next.
+ *
+ * The elements live in a PQHeap guarded by one mutex. The queue holds at
+ * most capacity elements: an enqueue into a full queue waits until a consumer
+ * makes room, which slows producers down to the pace of the consumers instead
+ * of letting the queue grow without bound. A dequeue from an empty queue
+ * waits until a producer adds something. Each wait comes in a timed variant
+ * that gives up after a deadline.
+ *
+ * dequeueBatch takes up to n elements for the price of one lock acquisition
+ * and one wake-up, which matters when consumers handle small items quickly.
+ *
+ * close() ends the pipeline: later enqueues fail, and consumers drain what is
+ * left and are then told there is nothing more instead of waiting forever.
+ *
+ * T and Compare are as for BasicPQHeap: compare(a, b) returns true when a
+ * should be dequeued before b.
+ */
+template <typename T = DataPoint, typename Compare = LowerPriorityFirst>
+class BlockingPQueue {
+public:
+    /**
+     * Creates a new, empty, open queue that holds at most capacity elements.
+     * If capacity is less than 1, this function calls error().
+     */
+    explicit BlockingPQueue(int capacity, Compare compare = Compare());
+
+    /**
+     * Adds element, first waiting for room if the queue is full. If the queue
+     * is or becomes closed, this function calls error().
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Adds element if room appears within timeout. Returns false, leaving
+     * element untouched, if the wait times out or the queue is closed.
+     */
+    template <typename Rep, typename Period>
+    bool enqueueFor(T&& element, const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * Removes and returns the frontmost element, first waiting for one if the
+     * queue is empty. If the queue is closed and empty, this function calls
+     * error().
+     */
+    T dequeue();
+
+    /**
+     * Removes the frontmost element into result if one is or becomes available
+     * within timeout. Returns false if the wait times out, or at once if the
+     * queue is closed and empty.
+     */
+    template <typename Rep, typename Period>
+    bool dequeueFor(T& result, const std::chrono::duration<Rep, Period>& timeout);
+
+    /**
+     * Waits until the queue is not empty, then removes and returns up to n
+     * elements, frontmost first, all under a single acquisition of the lock.
+     * Returns an empty Vector once the queue is closed and empty. If n is less
+     * than 1, this function calls error().
+     */
+    Vector<T> dequeueBatch(int n);
+
+    /**
+     * Closes the queue. Waiting producers fail and waiting consumers wake up;
+     * elements already queued can still be dequeued. Closing twice is harmless.
+     */
+    void close();
+
+    /**
+     * Returns whether close() has been called.
+     */
+    bool isClosed() const;
+
+    /**
+     * Returns the number of elements queued. With other threads at work this
+     * is only a snapshot.
+     */
+    int size() const;
+
+    /**
+     * Returns whether the queue is empty, with the same caveat as size().
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the most elements the queue holds at once.
+     */
+    int capacity() const;
+
+private:
+    /* Adds element; the caller holds the lock and has made sure there is room. */
+    void place(std::unique_lock<std::mutex>& guard, T&& element);
+
+    /* Removes the front; the caller holds the lock and has made sure there is one. */
+    T take(std::unique_lock<std::mutex>& guard);
+
+    mutable std::mutex _lock;               // guards everything below
+    std::condition_variable _notFull;       // signalled when an element leaves or the queue closes
+    std::condition_variable _notEmpty;      // signalled when an element arrives or the queue closes
+    BasicPQHeap<T, Compare> _heap;
+    int _capacity;
+    bool _closed;
+
+    DISALLOW_COPYING_OF(BlockingPQueue);
+};
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+template <typename T, typename Compare>
+BlockingPQueue<T, Compare>::BlockingPQueue(int capacity, Compare compare) :
+    _heap(std::move(compare)), _capacity(capacity), _closed(false) {
+    if (capacity < 1) {
+        error("BlockingPQueue capacity must be at least 1!");
+    }
+}
+
+template <typename T, typename Compare>
+void BlockingPQueue<T, Compare>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+template <typename T, typename Compare>
+void BlockingPQueue<T, Compare>::enqueue(T&& element) {
+    std::unique_lock<std::mutex> guard(_lock);
+    _notFull.wait(guard, [this] { return _closed || _heap.size() < _capacity; });
+    if (_closed) {
+        error("Cannot enqueue because BlockingPQueue is closed!");
+    }
+    place(guard, std::move(element));
+}
+
+template <typename T, typename Compare>
+template <typename Rep, typename Period>
+bool BlockingPQueue<T, Compare>::enqueueFor(T&& element, const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<std::mutex> guard(_lock);
+    if (!_notFull.wait_for(guard, timeout, [this] { return _closed || _heap.size() < _capacity; }) || _closed) {
+        return false;
+    }
+    place(guard, std::move(element));
+    return true;
+}
+
+template <typename T, typename Compare>
+T BlockingPQueue<T, Compare>::dequeue() {
+    std::unique_lock<std::mutex> guard(_lock);
+    _notEmpty.wait(guard, [this] { return _closed || !_heap.isEmpty(); });
+    if (_heap.isEmpty()) {
+        error("Cannot dequeue because BlockingPQueue is closed and empty!");
+    }
+    return take(guard);
+}
+
+template <typename T, typename Compare>
+template <typename Rep, typename Period>
+bool BlockingPQueue<T, Compare>::dequeueFor(T& result, const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<std::mutex> guard(_lock);
+    if (!_notEmpty.wait_for(guard, timeout, [this] { return _closed || !_heap.isEmpty(); }) || _heap.isEmpty()) {
+        return false;
+    }
+    result = take(guard);
+    return true;
+}
+
+/*
+ * Every element taken frees a slot, so all waiting producers are woken at once rather than one
+ * per element; those that find no room left just wait again.
+ */
+template <typename T, typename Compare>
+Vector<T> BlockingPQueue<T, Compare>::dequeueBatch(int n) {
+    if (n < 1) {
+        error("BlockingPQueue::dequeueBatch needs n of at least 1!");
+    }
+    std::unique_lock<std::mutex> guard(_lock);
+    _notEmpty.wait(guard, [this] { return _closed || !_heap.isEmpty(); });
+
+    int count = std::min(n, _heap.size());
+    Vector<T> batch(count);
+    for (int i = 0; i < count; i++) {
+        batch[i] = _heap.dequeue();
+    }
+    guard.unlock();
+    if (count > 0) {
+        _notFull.notify_all();
+    }
+    return batch;
+}
+
+template <typename T, typename Compare>
+void BlockingPQueue<T, Compare>::close() {
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _closed = true;
+    }
+    _notFull.notify_all();
+    _notEmpty.notify_all();
+}
+
+template <typename T, typename Compare>
+bool BlockingPQueue<T, Compare>::isClosed() const {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _closed;
+}
+
+template <typename T, typename Compare>
+int BlockingPQueue<T, Compare>::size() const {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _heap.size();
+}
+
+template <typename T, typename Compare>
+bool BlockingPQueue<T, Compare>::isEmpty() const {
+    return size() == 0;
+}
+
+template <typename T, typename Compare>
+int BlockingPQueue<T, Compare>::capacity() const {
+    return _capacity;
+}
+
+/*
+ * The waiting thread is notified after the lock is released, so it does not wake only to block on it.
+ */
+template <typename T, typename Compare>
+void BlockingPQueue<T, Compare>::place(std::unique_lock<std::mutex>& guard, T&& element) {
+    _heap.enqueue(std::move(element));
+    guard.unlock();
+    _notEmpty.notify_one();
+}
+
+template <typename T, typename Compare>
+T BlockingPQueue<T, Compare>::take(std::unique_lock<std::mutex>& guard) {
+    T result = _heap.dequeue();
+    guard.unlock();
+    _notFull.notify_one();
+    return result;
+}
@@ -0,0 +1,108 @@
+/*
+ * This file, boundedtopk, holds the test cases for the BoundedTopK class template defined in boundedtopk.h,
+ * and a time trial comparing it with the enqueue-then-dequeue approach topK used to take.
+ */
+#include "boundedtopk.h"
+#include "pqheap.h"
+#include "random.h"
+#include "SimpleTest.h"
+#include <algorithm>
+#include <functional>
+using namespace std;
+
+template class BoundedTopK<DataPoint>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("BoundedTopK: keeps the k highest priorities, returned highest first") {
+    BoundedTopK<> best(3);
+    EXPECT_EQUAL(best.capacity(), 3);
+    EXPECT_ERROR(best.weakest());
+
+    EXPECT(best.offer({"A", 1}));
+    EXPECT(best.offer({"B", 5}));
+    EXPECT(best.offer({"C", 3}));
+    EXPECT(best.isFull());
+    EXPECT_EQUAL(best.weakest(), {"A", 1});
+
+    EXPECT(!best.offer({"D", 0}));      // rejected by one compare
+    EXPECT(!best.offer({"E", 1}));      // ties with the weakest are rejected too
+    EXPECT(best.offer({"F", 4}));       // replaces A
+    EXPECT_EQUAL(best.size(), 3);
+    EXPECT_EQUAL(best.weakest(), {"C", 3});
+
+    Vector<DataPoint> expected = { {"B", 5}, {"F", 4}, {"C", 3} };
+    EXPECT_EQUAL(best.takeDescending(), expected);
+    EXPECT_EQUAL(best.size(), 0);
+}
+
+STUDENT_TEST("BoundedTopK: k of zero keeps nothing, negative k is an error") {
+    BoundedTopK<> none(0);
+    EXPECT(!none.offer({"A", 100}));
+    EXPECT(none.takeDescending().isEmpty());
+    EXPECT_ERROR(BoundedTopK<> bad(-1));
+}
+
+STUDENT_TEST("BoundedTopK: matches a full sort on random input, custom ordering") {
+    setRandomSeed(11);
+    Vector<int> values;
+    for (int i = 0; i < 2000; i++) {
+        values.add(randomInteger(-500, 500));
+    }
+
+    /* greater<int> as "ranks below" keeps the smallest values, smallest first. */
+    BoundedTopK<int, greater<int>> smallest(25);
+    for (int value : values) {
+        smallest.offer(value);
+    }
+    Vector<int> sorted = values;
+    sorted.sort();
+    Vector<int> result = smallest.takeDescending();
+    EXPECT_EQUAL(result.size(), 25);
+    for (int i = 0; i < 25; i++) {
+        EXPECT_EQUAL(result[i], sorted[i]);
+    }
+}
+
+/* The approach topK used before BoundedTopK: enqueue every point, evict the minimum once
+ * the heap holds more than k. */
+Vector<DataPoint> topKByEnqueueDequeue(const Vector<DataPoint>& input, int k) {
+    PQHeap pq;
+    for (const DataPoint& pt : input) {
+        pq.enqueue(pt);
+        if (pq.size() > k) {
+            pq.dequeue();
+        }
+    }
+    Vector<DataPoint> result(pq.size());
+    for (int i = pq.size() - 1; i >= 0; i--) {
+        result[i] = pq.dequeue();
+    }
+    return result;
+}
+
+Vector<DataPoint> topKByBoundedTopK(const Vector<DataPoint>& input, int k) {
+    BoundedTopK<> best(k);
+    for (const DataPoint& pt : input) {
+        best.offer(pt);
+    }
+    return best.takeDescending();
+}
+
+STUDENT_TEST("BoundedTopK: time against enqueue/dequeue at k = 10, 1000, 100000") {
+    int n = 2000000;
+    Vector<DataPoint> input;
+    for (int i = 0; i < n; i++) {
+        input.add({"", randomReal(0, 100)});
+    }
+    for (int k : { 10, 1000, 100000 }) {
+        Vector<DataPoint> before, after;
+        TIME_OPERATION(k, before = topKByEnqueueDequeue(input, k));
+        TIME_OPERATION(k, after = topKByBoundedTopK(input, k));
+        EXPECT_EQUAL(after.size(), k);
+        for (int i = 0; i < k; i++) {
+            EXPECT_EQUAL(after[i].priority, before[i].priority);
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include "strlib.h"
+#include "vector.h"
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+/**
+ * The ranking topK and its variants use: higher priority ranks higher and, among
+ * equal priorities, the alphabetically first label ranks higher. Comparing
+ * priorities alone leaves ties to arrival order and heap layout; this is a total
+ * order on distinct DataPoints, so which k points win, and their order, depend
+ * only on the input. That is what lets parallelTopK reproduce topK exactly.
+ *
+ * Works for any type with a priority member and a labelLess overload; the one
+ * for DataPointView is in mappeddatapoints.h.
+ */
+inline bool labelLess(const DataPoint& lhs, const DataPoint& rhs) {
+    return lhs.label < rhs.label;
+}
+
+struct PriorityThenLabelRank {
+    template <typename T>
+    bool operator()(const T& lhs, const T& rhs) const {
+        if (lhs.priority != rhs.priority) {
+            return lhs.priority < rhs.priority;
+        }
+        return labelLess(rhs, lhs);
+    }
+};
+
+/**
+ * Container that keeps the k highest-ranked elements offered to it.
+ *
+ * Internally this is a heap of at most k elements whose frontmost element is
+ * the weakest survivor. Each offered element is first compared against that
+ * survivor: if it does not outrank it, it is rejected after a single
+ * comparison, and otherwise it takes the survivor's place with one
+ * percolate-down (BasicPQHeap::replaceTop). Compared with enqueueing every
+ * element and dequeueing the minimum whenever the heap grows past k, this
+ * does at most one O(log k) walk per element, and none for rejected ones.
+ *
+ * less(a, b) must return true when a ranks below b. The default,
+ * LowerPriorityFirst, keeps the elements with the highest priority values.
+ *
+ * Heap is the queue the survivors are kept in, a BasicPQHeap<T, Less> by
+ * default. For a small k, a StaticPQHeap<N, T, Less> keeps them in the
+ * container itself instead, so that a BoundedTopK on the stack does no
+ * allocation of its own. Any heap other than BasicPQHeap must have a static
+ * capacity() of at least k.
+ */
+template <typename T = DataPoint, typename Less = LowerPriorityFirst, typename Heap = BasicPQHeap<T, Less>>
+class BoundedTopK {
+public:
+    /**
+     * Creates an empty container that keeps at most k elements. If k is
+     * negative or more than a fixed-capacity Heap holds, this function calls
+     * error().
+     */
+    explicit BoundedTopK(int k, Less less = Less());
+
+    /**
+     * Offers element to the container. It is kept if the container is not yet
+     * full, or if it outranks the weakest element currently kept, which is
+     * then discarded. Ties with the weakest element are rejected.
+     *
+     * This operation runs in time O(1) for a rejected element and O(log k)
+     * otherwise.
+     *
+     * @return true if element was kept, false if it was rejected.
+     */
+    bool offer(const T& element);
+    bool offer(T&& element);
+
+    /**
+     * Returns, but does not remove, the weakest element currently kept.
+     * If the container is empty, this function calls error().
+     */
+    const T& weakest() const;
+
+    /**
+     * Returns the number of elements kept, which never exceeds capacity().
+     */
+    int size() const;
+
+    /**
+     * Returns k, the maximum number of elements kept.
+     */
+    int capacity() const;
+
+    /**
+     * Returns whether the container holds capacity() elements.
+     */
+    bool isFull() const;
+
+    /**
+     * Removes every kept element and returns them in descending order of rank,
+     * i.e. highest priority first. The container is empty afterwards.
+     *
+     * This operation runs in time O(k log k).
+     */
+    Vector<T> takeDescending();
+
+private:
+    int _capacity;                  // k, the most elements ever kept
+    Less _less;                     // less(a, b) is true when a ranks below b
+    Heap _kept;                     // min-heap under _less: weakest survivor in front
+
+    DISALLOW_COPYING_OF(BoundedTopK);
+};
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+template <typename T, typename Less, typename Heap>
+BoundedTopK<T, Less, Heap>::BoundedTopK(int k, Less less) : _capacity(k), _less(less), _kept(less) {
+    if (k < 0) {
+        error("BoundedTopK capacity cannot be negative!");
+    }
+    if constexpr (!std::is_same<Heap, BasicPQHeap<T, Less>>::value) {
+        if (k > Heap::capacity()) {
+            error("BoundedTopK capacity " + integerToString(k) + " does not fit its heap of "
+                  + integerToString(Heap::capacity()) + " elements!");
+        }
+    }
+}
+
+template <typename T, typename Less, typename Heap>
+bool BoundedTopK<T, Less, Heap>::offer(const T& element) {
+    if (isFull() && (_capacity == 0 || !_less(_kept.peek(), element))) {
+        return false;
+    }
+    return offer(T(element));
+}
+
+/*
+ * Fills the heap until it holds k elements. After that an element is only
+ * admitted if it outranks the front of the heap, and it goes straight into
+ * the front's slot.
+ */
+template <typename T, typename Less, typename Heap>
+bool BoundedTopK<T, Less, Heap>::offer(T&& element) {
+    if (!isFull()) {
+        _kept.enqueue(std::move(element));
+        return true;
+    }
+    if (_capacity == 0 || !_less(_kept.peek(), element)) {
+        return false;
+    }
+    _kept.replaceTop(std::move(element));
+    return true;
+}
+
+template <typename T, typename Less, typename Heap>
+const T& BoundedTopK<T, Less, Heap>::weakest() const {
+    if (_kept.isEmpty()) {
+        error("Cannot access weakest element of empty BoundedTopK!");
+    }
+    return _kept.peek();
+}
+
+template <typename T, typename Less, typename Heap>
+int BoundedTopK<T, Less, Heap>::size() const {
+    return _kept.size();
+}
+
+template <typename T, typename Less, typename Heap>
+int BoundedTopK<T, Less, Heap>::capacity() const {
+    return _capacity;
+}
+
+template <typename T, typename Less, typename Heap>
+bool BoundedTopK<T, Less, Heap>::isFull() const {
+    return size() >= _capacity;
+}
+
+/*
+ * The heap hands elements back weakest first, so they are written into the
+ * result from the back, all in one dequeueMany.
+ */
+template <typename T, typename Less, typename Heap>
+Vector<T> BoundedTopK<T, Less, Heap>::takeDescending() {
+    int count = _kept.size();
+    Vector<T> result(count);
+    if (count > 0) {
+        _kept.dequeueMany(count, std::reverse_iterator<T*>(&result[0] + count));
+    }
+    return result;
+}
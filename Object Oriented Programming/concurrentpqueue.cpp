@@ -0,0 +1,164 @@
+/*
+ * This file, concurrentpqueue, holds the test cases for the ConcurrentPQueue class template defined in
+ * concurrentpqueue.h, and a contention benchmark against a PQHeap behind a single mutex.
+ */
+#include "concurrentpqueue.h"
+#include "pqheap.h"
+#include "random.h"
+#include "strlib.h"
+#include "SimpleTest.h"
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+template class ConcurrentPQueue<DataPoint>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("ConcurrentPQueue: with one shard it behaves exactly like PQHeap") {
+    setRandomSeed(15);
+    ConcurrentPQueue<DataPoint> pq(1);
+    PQHeap reference;
+    for (int i = 0; i < 5000; i++) {
+        if (randomChance(0.6) || reference.isEmpty()) {
+            DataPoint elem = {"", double(randomInteger(-100, 100))};
+            reference.enqueue(elem);
+            pq.enqueue(elem);
+        } else {
+            double expected = reference.dequeue().priority;
+            EXPECT_EQUAL(pq.dequeue().priority, expected);
+        }
+        EXPECT_EQUAL(pq.size(), reference.size());
+    }
+    pq.clear();
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.dequeue());
+    DataPoint untouched = {"untouched", 1};
+    EXPECT(!pq.tryDequeue(untouched));
+    EXPECT_EQUAL(untouched, {"untouched", 1});
+    EXPECT_ERROR(ConcurrentPQueue<DataPoint>(-1));
+}
+
+STUDENT_TEST("ConcurrentPQueue: relaxed dequeue order stays close to the true order") {
+    ConcurrentPQueue<DataPoint> pq(8);
+    int n = 10000;
+    for (int i = 0; i < n; i++) {
+        pq.enqueue({"", double(randomInteger(0, n - 1))});
+    }
+
+    /* Measure how far ahead of its place in sorted order any element comes out. With 8 shards
+     * the dequeued element is always a shard front, so the lead stays small next to n. */
+    int largestLead = 0;
+    Vector<double> order;
+    while (!pq.isEmpty()) {
+        order.add(pq.dequeue().priority);
+    }
+    Vector<double> sorted = order;
+    sorted.sort();
+    for (int i = 0; i < n; i++) {
+        int rank = 0;
+        while (sorted[rank] < order[i]) rank++;
+        largestLead = max(largestLead, rank - i);
+    }
+    EXPECT_EQUAL(order.size(), n);
+    EXPECT(largestLead < n / 10);
+}
+
+STUDENT_TEST("ConcurrentPQueue: many producers and consumers see every element exactly once") {
+    ConcurrentPQueue<DataPoint> pq(16);
+    int numProducers = 8, numConsumers = 8, perProducer = 20000;
+    int total = numProducers * perProducer;
+    vector<vector<int>> seen(numConsumers);
+    atomic<int> consumed(0);
+
+    vector<thread> threads;
+    for (int p = 0; p < numProducers; p++) {
+        threads.emplace_back([&pq, p, perProducer] {
+            for (int i = 0; i < perProducer; i++) {
+                int id = p * perProducer + i;
+                pq.enqueue({ to_string(id), double(id % 977) });
+            }
+        });
+    }
+    for (int c = 0; c < numConsumers; c++) {
+        threads.emplace_back([&, c] {
+            DataPoint pt;
+            while (consumed.load() < total) {
+                if (pq.tryDequeue(pt)) {
+                    seen[c].push_back(stoi(pt.label));
+                    consumed++;
+                }
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    Vector<int> timesSeen(total, 0);
+    for (const vector<int>& ids : seen) {
+        for (int id : ids) {
+            timesSeen[id]++;
+        }
+    }
+    EXPECT_EQUAL(timesSeen, Vector<int>(total, 1));
+    EXPECT(pq.isEmpty());
+}
+
+/* The obvious alternative: one PQHeap that every thread has to lock. */
+class LockedPQHeap {
+public:
+    void enqueue(DataPoint&& pt) {
+        lock_guard<mutex> guard(_lock);
+        _heap.enqueue(std::move(pt));
+    }
+
+    bool tryDequeue(DataPoint& result) {
+        lock_guard<mutex> guard(_lock);
+        if (_heap.isEmpty()) {
+            return false;
+        }
+        result = _heap.dequeue();
+        return true;
+    }
+
+private:
+    mutex _lock;
+    PQHeap _heap;
+};
+
+/* Every thread alternates enqueue and dequeue for its share of totalOps pairs, as a work pool with a
+ * steady backlog does. */
+template <typename Queue>
+static void churn(Queue& pq, int numThreads, int totalOps) {
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&pq, t, numThreads, totalOps] {
+            DataPoint pt;
+            for (int i = t; i < totalOps; i += numThreads) {
+                pq.enqueue({ "", double(int64_t(i) * 7919 % 100003) });
+                pq.tryDequeue(pt);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+}
+
+STUDENT_TEST("ConcurrentPQueue: contention benchmark from 1 to 64 threads against a locked PQHeap") {
+    int totalOps = 1000000;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        LockedPQHeap locked;
+        ConcurrentPQueue<DataPoint> relaxed(2 * threads);
+        for (int i = 0; i < 100000; i++) {
+            locked.enqueue({ "", double(i % 100003) });
+            relaxed.enqueue({ "", double(i % 100003) });
+        }
+        TIME_OPERATION(threads, churn(locked, threads, totalOps));
+        TIME_OPERATION(threads, churn(relaxed, threads, totalOps));
+    }
+}
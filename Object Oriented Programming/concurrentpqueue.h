@@ -0,0 +1,256 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * Priority queue that many threads can enqueue to and dequeue from at once,
+ * built as a relaxed multi-queue.
+ *
+ * Elements are spread over several shards, each an ordinary PQHeap with its
+ * own lock. enqueue puts the element in a random shard; dequeue looks at the
+ * fronts of two random shards and takes the more urgent one. Threads only
+ * collide when they pick the same shard at the same moment, and they then just
+ * pick again instead of waiting, so throughput keeps growing with the thread
+ * count where a single PQHeap behind one mutex serializes every operation.
+ *
+ * The price is that dequeue is relaxed: it returns an element close to the
+ * front, not necessarily the frontmost. With s shards the element returned is
+ * typically among the first O(s) in priority order, and every element is
+ * dequeued exactly once. With one shard the queue is exact.
+ *
+ * T and Compare are as for BasicPQHeap: compare(a, b) returns true when a
+ * should be dequeued before b. The comparator is copied into every shard.
+ */
+template <typename T = DataPoint, typename Compare = LowerPriorityFirst>
+class ConcurrentPQueue {
+public:
+    /**
+     * Creates a new, empty queue with numShards shards, or two per hardware
+     * thread if numShards is 0. If numShards is negative, this function calls
+     * error().
+     */
+    explicit ConcurrentPQueue(int numShards = 0, Compare compare = Compare());
+
+    /**
+     * Adds a new element into the queue. Safe to call from any number of
+     * threads at once.
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Removes an element at or near the front of the queue and stores it in
+     * result. Returns false, leaving result alone, if the queue was empty. Safe
+     * to call from any number of threads at once.
+     *
+     * If no enqueue runs at the same time, a false return means the queue really
+     * is empty.
+     */
+    bool tryDequeue(T& result);
+
+    /**
+     * Removes and returns an element at or near the front of the queue. If the
+     * queue is empty, this function calls error().
+     */
+    T dequeue();
+
+    /**
+     * Returns the number of elements in the queue. While other threads are
+     * enqueueing or dequeueing, this is only a snapshot.
+     */
+    int size() const;
+
+    /**
+     * Returns whether the queue is empty, with the same caveat as size().
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the number of shards the elements are spread over.
+     */
+    int numShards() const;
+
+    /**
+     * Removes all elements from the queue.
+     */
+    void clear();
+
+private:
+    /* Attempts at random shards before enqueue waits for a busy one, or dequeue falls back to checking
+     * every shard in turn. */
+    static const int RANDOM_ATTEMPTS = 16;
+
+    /* A PQHeap and the lock that guards it, on its own cache line so that threads working on
+     * neighbouring shards do not slow each other down. */
+    struct alignas(64) Shard {
+        explicit Shard(const Compare& compare) : heap(compare), count(0) {}
+        std::mutex lock;
+        BasicPQHeap<T, Compare> heap;
+        std::atomic<int> count;     // heap.size(), readable without taking the lock
+    };
+
+    int randomShard() const; // an index in [0, numShards()) from a per-thread generator
+    void place(T&& element); // locks a random shard, free if one turns up, and enqueues element there
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    std::atomic<int> _size;     // elements in all shards
+    Compare _compare;           // compare(a, b) is true when a is more urgent than b
+
+    DISALLOW_COPYING_OF(ConcurrentPQueue);
+};
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+template <typename T, typename Compare>
+ConcurrentPQueue<T, Compare>::ConcurrentPQueue(int numShards, Compare compare) : _size(0), _compare(compare) {
+    if (numShards < 0) {
+        error("ConcurrentPQueue cannot have a negative number of shards!");
+    }
+    if (numShards == 0) {
+        numShards = 2 * std::max(1, int(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < numShards; i++) {
+        _shards.push_back(std::make_unique<Shard>(_compare));
+    }
+}
+
+template <typename T, typename Compare>
+void ConcurrentPQueue<T, Compare>::enqueue(const T& element) {
+    place(T(element));
+}
+
+template <typename T, typename Compare>
+void ConcurrentPQueue<T, Compare>::enqueue(T&& element) {
+    place(std::move(element));
+}
+
+/*
+ * try_lock never waits: a shard that is busy is simply passed over for another random one. Once
+ * RANDOM_ATTEMPTS shards in a row have come up busy, the last one is waited for instead, as tryDequeue
+ * does, so that a producer does not spin through its time slice while the threads holding the locks are
+ * descheduled.
+ */
+template <typename T, typename Compare>
+void ConcurrentPQueue<T, Compare>::place(T&& element) {
+    Shard* shard = nullptr;
+    bool locked = false;
+    for (int attempt = 0; attempt < RANDOM_ATTEMPTS && !locked; attempt++) {
+        shard = _shards[randomShard()].get();
+        locked = shard->lock.try_lock();
+    }
+    if (!locked) {
+        shard->lock.lock();
+    }
+    std::lock_guard<std::mutex> guard(shard->lock, std::adopt_lock);
+    shard->heap.enqueue(std::move(element));
+    shard->count.store(shard->heap.size(), std::memory_order_relaxed);
+    _size++;
+}
+
+/*
+ * Two random shards are locked, if both are free, and the more urgent of their fronts is taken. Shards
+ * whose count says they are empty are not locked at all. Once RANDOM_ATTEMPTS pairs have come up busy
+ * or empty, every shard is visited in turn, waiting for its lock this time, so an element that is in
+ * the queue cannot be missed just because of bad luck.
+ */
+template <typename T, typename Compare>
+bool ConcurrentPQueue<T, Compare>::tryDequeue(T& result) {
+    for (int attempt = 0; attempt < RANDOM_ATTEMPTS && _size.load() > 0; attempt++) {
+        Shard* first = _shards[randomShard()].get();
+        Shard* second = _shards[randomShard()].get();
+        if (first->count.load(std::memory_order_relaxed) == 0) {
+            std::swap(first, second);
+        }
+        if (second->count.load(std::memory_order_relaxed) == 0) {
+            second = first;
+        }
+        if (first->count.load(std::memory_order_relaxed) == 0 || !first->lock.try_lock()) {
+            continue;
+        }
+        if (second != first && !second->lock.try_lock()) {
+            second = first;
+        }
+        std::unique_lock<std::mutex> firstGuard(first->lock, std::adopt_lock);
+        std::unique_lock<std::mutex> secondGuard;
+        if (second != first) {
+            secondGuard = std::unique_lock<std::mutex>(second->lock, std::adopt_lock);
+        }
+
+        Shard* best = first;
+        if (best->heap.isEmpty()
+                || (!second->heap.isEmpty() && _compare(second->heap.peek(), best->heap.peek()))) {
+            best = second;
+        }
+        if (!best->heap.isEmpty()) {
+            result = best->heap.dequeue();
+            best->count.store(best->heap.size(), std::memory_order_relaxed);
+            _size--;
+            return true;
+        }
+    }
+
+    for (auto& shard : _shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        if (!shard->heap.isEmpty()) {
+            result = shard->heap.dequeue();
+            shard->count.store(shard->heap.size(), std::memory_order_relaxed);
+            _size--;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T, typename Compare>
+T ConcurrentPQueue<T, Compare>::dequeue() {
+    T result;
+    if (!tryDequeue(result)) {
+        error("Cannot dequeue because ConcurrentPQueue is empty!");
+    }
+    return result;
+}
+
+template <typename T, typename Compare>
+int ConcurrentPQueue<T, Compare>::size() const {
+    return _size.load();
+}
+
+template <typename T, typename Compare>
+bool ConcurrentPQueue<T, Compare>::isEmpty() const {
+    return size() == 0;
+}
+
+template <typename T, typename Compare>
+int ConcurrentPQueue<T, Compare>::numShards() const {
+    return int(_shards.size());
+}
+
+template <typename T, typename Compare>
+void ConcurrentPQueue<T, Compare>::clear() {
+    for (auto& shard : _shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        _size -= shard->heap.size();
+        shard->heap.clear();
+        shard->count.store(0, std::memory_order_relaxed);
+    }
+}
+
+/*
+ * Each thread gets its own generator, seeded from its id, so picking a shard needs no shared state.
+ */
+template <typename T, typename Compare>
+int ConcurrentPQueue<T, Compare>::randomShard() const {
+    thread_local std::minstd_rand generator(unsigned(std::hash<std::thread::id>()(std::this_thread::get_id())));
+    return int(generator() % _shards.size());
+}
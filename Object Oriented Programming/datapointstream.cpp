@@ -0,0 +1,242 @@
+/*
+ * This file, datapointstream, implements the binary DataPoint reader and writer declared in
+ * datapointstream.h, followed by their test cases.
+ */
+#include "datapointstream.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include "SimpleTest.h"
+using namespace std;
+
+const char kDataPointStreamMagic[4] = { 'D', 'P', 'B', '1' };
+
+/* Records are assembled in the writer's buffer until it holds about this many bytes. */
+const size_t kWriterFlushThreshold = 1 << 16;
+
+/* The label length is stored in 32 bits, so longer labels cannot be written at all. */
+static void checkLabelFits(const DataPoint& pt) {
+    if (pt.label.size() > UINT32_MAX) {
+        error("DataPoint label of " + to_string(pt.label.size()) + " bytes is too long for the binary format!");
+    }
+}
+
+/*
+ * Multi-byte fields are stored little-endian one byte at a time, so the format does not
+ * depend on the byte order of the machine doing the reading or writing.
+ */
+void encodeDataPointRecord(const DataPoint& pt, char* out) {
+    checkLabelFits(pt);
+    uint32_t length = uint32_t(pt.label.size());
+    for (int i = 0; i < 4; i++) {
+        out[i] = char((length >> (8 * i)) & 0xFF);
+    }
+    memcpy(out + 4, pt.label.data(), pt.label.size());
+
+    uint64_t bits;
+    memcpy(&bits, &pt.priority, sizeof(bits));
+    char* priority = out + 4 + pt.label.size();
+    for (int i = 0; i < 8; i++) {
+        priority[i] = char((bits >> (8 * i)) & 0xFF);
+    }
+}
+
+size_t decodeRecordLength(const char* in) {
+    uint32_t length = 0;
+    for (int i = 0; i < 4; i++) {
+        length |= uint32_t(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return length;
+}
+
+double decodeRecordPriority(const char* in) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+        bits |= uint64_t(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    double priority;
+    memcpy(&priority, &bits, sizeof(priority));
+    return priority;
+}
+
+
+/* * * * * * DataPointWriter * * * * * */
+
+DataPointWriter::DataPointWriter(ostream& out) : _out(out), _wroteMagic(false) {
+    _buffer.reserve(kWriterFlushThreshold + 256);
+}
+
+DataPointWriter::~DataPointWriter() {
+    /* Destructors must not throw, so a failing stream is left for the caller to notice. */
+    if (!_buffer.empty()) {
+        _out.write(_buffer.data(), _buffer.size());
+    }
+}
+
+/*
+ * Appends the record to the buffer, emitting the magic bytes first if this is the first
+ * record, and flushes once the buffer passes the threshold. A label too long for the format
+ * is rejected before the buffer grows, so nothing of the record reaches the stream.
+ */
+void DataPointWriter::write(const DataPoint& pt) {
+    checkLabelFits(pt);
+    if (!_wroteMagic) {
+        _buffer.append(kDataPointStreamMagic, sizeof(kDataPointStreamMagic));
+        _wroteMagic = true;
+    }
+
+    size_t start = _buffer.size();
+    _buffer.resize(start + kDataPointRecordOverhead + pt.label.size());
+    encodeDataPointRecord(pt, &_buffer[start]);
+
+    if (_buffer.size() >= kWriterFlushThreshold) {
+        flush();
+    }
+}
+
+void DataPointWriter::flush() {
+    if (!_buffer.empty()) {
+        _out.write(_buffer.data(), _buffer.size());
+        _buffer.clear();
+    }
+    _out.flush();
+    if (!_out) {
+        error("DataPointWriter could not write to its stream!");
+    }
+}
+
+
+/* * * * * * DataPointReader * * * * * */
+
+DataPointReader::DataPointReader(istream& in) : _in(in), _buffer(BLOCK_SIZE), _pos(0), _end(0), _checkedMagic(false) {
+}
+
+/*
+ * Slides any unread bytes to the front of the buffer and reads from the stream until count
+ * bytes are available or it runs dry. If a single record is larger than the buffer, the buffer
+ * doubles each time it fills rather than growing to count at once: count comes from a length
+ * prefix, and a corrupt one must not allocate gigabytes before the stream turns out to be short.
+ */
+bool DataPointReader::ensureAvailable(size_t count) {
+    if (_end - _pos >= count) {
+        return true;
+    }
+
+    size_t unread = _end - _pos;
+    memmove(_buffer.data(), _buffer.data() + _pos, unread);
+    _pos = 0;
+    _end = unread;
+
+    while (_end < count && _in) {
+        if (_end == _buffer.size()) {
+            _buffer.resize(min(count, 2 * _buffer.size()));
+        }
+        _in.read(_buffer.data() + _end, _buffer.size() - _end);
+        _end += size_t(_in.gcount());
+    }
+    return _end >= count;
+}
+
+/*
+ * Decodes the next record directly out of the buffer. Running out of bytes between records
+ * is the normal end of the stream; running out inside one means the stream is corrupt.
+ */
+bool DataPointReader::read(DataPoint& result) {
+    if (!_checkedMagic) {
+        if (!ensureAvailable(sizeof(kDataPointStreamMagic))) {
+            if (_end == _pos) return false;
+            error("DataPointReader: stream is too short to hold the DataPoint header!");
+        }
+        if (memcmp(_buffer.data() + _pos, kDataPointStreamMagic, sizeof(kDataPointStreamMagic)) != 0) {
+            error("DataPointReader: stream is not in the binary DataPoint format!");
+        }
+        _pos += sizeof(kDataPointStreamMagic);
+        _checkedMagic = true;
+    }
+
+    if (!ensureAvailable(4)) {
+        if (_end == _pos) return false;
+        error("DataPointReader: stream ends inside a record's label length!");
+    }
+    size_t length = decodeRecordLength(_buffer.data() + _pos);
+    if (!ensureAvailable(kDataPointRecordOverhead + length)) {
+        error("DataPointReader: stream ends inside a record of label length " + to_string(length) + "!");
+    }
+
+    const char* record = _buffer.data() + _pos;
+    result.label.assign(record + 4, length);
+    result.priority = decodeRecordPriority(record + 4 + length);
+    _pos += kDataPointRecordOverhead + length;
+    return true;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("DataPointReader/Writer: round trip preserves labels and priorities exactly") {
+    Vector<DataPoint> input = {
+        { "", 0 },
+        { "plain", 106 },
+        { "quotes \" and \\ slashes", -3.25 },
+        { string("embedded\0nul", 12), 1e300 },
+        { "\x01\x7f\xff bytes", -0.0 },
+        { string(200000, 'x'), 0.1 },          // larger than one read block
+    };
+
+    stringstream stream;
+    {
+        DataPointWriter writer(stream);
+        for (const DataPoint& pt : input) {
+            writer.write(pt);
+        }
+    }
+
+    DataPointReader reader(stream);
+    DataPoint pt;
+    Vector<DataPoint> output;
+    while (reader.read(pt)) {
+        output.add(pt);
+    }
+    EXPECT_EQUAL(output, input);
+}
+
+STUDENT_TEST("DataPointReader: empty stream has no records, bad streams raise errors") {
+    stringstream empty;
+    DataPoint pt;
+    DataPointReader emptyReader(empty);
+    EXPECT(!emptyReader.read(pt));
+
+    stringstream text;
+    text << DataPoint{ "text", 1 };
+    DataPointReader textReader(text);
+    EXPECT_ERROR(textReader.read(pt));
+
+    stringstream full;
+    {
+        DataPointWriter writer(full);
+        writer.write({ "truncated", 2 });
+    }
+    string bytes = full.str();
+    stringstream truncated(bytes.substr(0, bytes.size() - 3));
+    DataPointReader truncatedReader(truncated);
+    EXPECT_ERROR(truncatedReader.read(pt));
+
+    /* A length prefix of nearly 4 GiB in front of a few bytes fails without reserving 4 GiB. */
+    stringstream corrupt(string(kDataPointStreamMagic, 4) + "\xF0\xFF\xFF\xFF" + "short label");
+    DataPointReader corruptReader(corrupt);
+    EXPECT_ERROR(corruptReader.read(pt));
+}
+
+STUDENT_TEST("DataPointWriter: a writer that writes nothing leaves the stream empty") {
+    stringstream stream;
+    {
+        DataPointWriter writer(stream);
+        writer.flush();
+    }
+    EXPECT_EQUAL(stream.str().size(), 0);
+}
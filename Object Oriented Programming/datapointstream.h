@@ -0,0 +1,117 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* A compact binary encoding of DataPoints for the hot paths where parsing the text
+ * format (operator>> in datapoint.h) costs more than the work done on the points.
+ *
+ * A binary stream starts with the four magic bytes "DPB1" and is followed by any
+ * number of records, each laid out as
+ *
+ *   label length   4 bytes, unsigned, little-endian
+ *   label          that many raw bytes, no escaping
+ *   priority       8 bytes, IEEE-754 double, little-endian
+ *
+ * A completely empty stream is also valid and holds no records. Byte order is fixed,
+ * so files can be moved between machines.
+ */
+
+/* The four bytes every non-empty binary DataPoint stream starts with. */
+extern const char kDataPointStreamMagic[4];
+
+/* Size in bytes of the fixed part of a record: label length plus priority. */
+const std::size_t kDataPointRecordOverhead = 4 + 8;
+
+/* Encodes a length-prefixed record for pt into the first kDataPointRecordOverhead +
+ * pt.label.size() bytes at out. Shared by the writer and any reader that needs it.
+ * If the label is 4 GiB or longer, its length does not fit the prefix and this
+ * function calls error().
+ */
+void encodeDataPointRecord(const DataPoint& pt, char* out);
+
+/* Decodes the 4-byte little-endian label length / 8-byte little-endian double at in. */
+std::size_t decodeRecordLength(const char* in);
+double decodeRecordPriority(const char* in);
+
+/**
+ * Writes DataPoints to an ostream in the binary format. Output is buffered and
+ * handed to the stream in large blocks; it is flushed when the buffer fills, when
+ * flush() is called and when the writer is destroyed.
+ */
+class DataPointWriter {
+public:
+    /**
+     * Creates a writer that appends to out. The magic bytes are written with the
+     * first record, so a writer that never writes leaves out untouched.
+     */
+    explicit DataPointWriter(std::ostream& out);
+
+    /**
+     * Flushes anything still buffered.
+     */
+    ~DataPointWriter();
+
+    /**
+     * Appends one record for pt. If pt's label is 4 GiB or longer, this
+     * function calls error() and writes nothing.
+     */
+    void write(const DataPoint& pt);
+
+    /**
+     * Passes all buffered records to the underlying stream. If the stream
+     * reports a failure, this function calls error().
+     */
+    void flush();
+
+private:
+    std::ostream& _out;
+    std::string _buffer;        // encoded records not yet handed to _out
+    bool _wroteMagic;           // whether the stream header has been emitted
+
+    DISALLOW_COPYING_OF(DataPointWriter);
+};
+
+/**
+ * Reads DataPoints from an istream in the binary format. The reader pulls the
+ * stream in large blocks into its own buffer and decodes records straight out
+ * of it, so there is no per-character stream access and no text parsing.
+ */
+class DataPointReader {
+public:
+    /**
+     * Creates a reader over in, which must be positioned at the start of a
+     * binary DataPoint stream.
+     */
+    explicit DataPointReader(std::istream& in);
+
+    /**
+     * Reads the next record into result, reusing result's label storage where
+     * possible. Returns false once the stream is exhausted at a record boundary.
+     * If the stream does not start with the magic bytes or ends partway through
+     * a record, this function calls error().
+     *
+     * Usage mirrors the text format:  while (reader.read(pt)) { ... }
+     */
+    bool read(DataPoint& result);
+
+private:
+    static const std::size_t BLOCK_SIZE = 1 << 16;
+
+    /* Makes at least count unread bytes available at _pos, refilling and growing
+     * the buffer as needed, but no faster than bytes arrive. Returns false if the
+     * stream ends first. */
+    bool ensureAvailable(std::size_t count);
+
+    std::istream& _in;
+    std::vector<char> _buffer;  // bytes read from _in; unread ones are [_pos, _end)
+    std::size_t _pos;
+    std::size_t _end;
+    bool _checkedMagic;         // whether the stream header has been consumed
+
+    DISALLOW_COPYING_OF(DataPointReader);
+};
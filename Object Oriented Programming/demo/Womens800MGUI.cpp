@@ -1,5 +1,6 @@
 #include "ProblemHandler.h"
 #include "../pqclient.h"
+#include "../pqheap.h"
 #include "GUIUtils.h"
 #include "CSV.h"
 #include "TemporaryComponent.h"
@@ -119,21 +120,24 @@ namespace {
         Vector<SwimResult> allData = parseCSVsIn(baseDir);
 
         /* We how have a bunch of time series. We can sort them by year by
-         * using pqSort (key = index, value = year).
+         * building a PQHeap over all of them in one go (key = index, value = year)
+         * and dequeuing them in order.
          */
         Vector<DataPoint> byYear(allData.size());
         for (int i = 0; i < allData.size(); i++) {
             byYear[i] = { to_string(i), double(allData[i].year) };
         }
-        pqSort(byYear);
+        PQHeap byYearQueue;
+        byYearQueue.buildFrom(std::move(byYear));
         auto result = allData;
-        for (int i = 0; i < byYear.size(); i++) {
-            if (!stringIsInteger(byYear[i].label) || stringToInteger(byYear[i].label) >= byYear.size()) {
+        for (int i = 0; !byYearQueue.isEmpty(); i++) {
+            DataPoint next = byYearQueue.dequeue();
+            if (!stringIsInteger(next.label) || stringToInteger(next.label) >= allData.size()) {
                 ostringstream out;
-                out << "pqSort result contains erroneous DataPoint " << byYear[i];
+                out << "PQHeap result contains erroneous DataPoint " << next;
                 error(out.str());
             }
-            result[i] = allData[stringToInteger(byYear[i].label)];
+            result[i] = allData[stringToInteger(next.label)];
         }
         return result;
     }
@@ -0,0 +1,381 @@
+/*
+ * This file, externalsort, implements pqSortExternal, the sort for DataPoint streams too large to hold
+ * in memory, followed by its test cases.
+ */
+#include "externalsort.h"
+#include "datapointstream.h"
+#include "error.h"
+#include "pqheap.h"
+#include "random.h"
+#include "strlib.h"
+#include "vector.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "SimpleTest.h"
+using namespace std;
+
+namespace {
+    /* DataPointReader and DataPointWriter each buffer about this many bytes of their stream. */
+    const size_t kStreamBufferBytes = 1 << 16;
+
+    /* Never merge more runs than this at once, however large the budget. */
+    const int kMaxMergeFanIn = 256;
+
+    /* A point waiting in the run-formation heap, tagged with the run it will be written to. */
+    struct SpillEntry {
+        int run;
+        DataPoint point;
+    };
+
+    /* Points for the current run come before points held back for the next one. */
+    struct SpillOrder {
+        bool operator()(const SpillEntry& lhs, const SpillEntry& rhs) const {
+            if (lhs.run != rhs.run) {
+                return lhs.run < rhs.run;
+            }
+            return lhs.point.priority < rhs.point.priority;
+        }
+    };
+
+    /* What holding pt in the run-formation heap counts against the memory budget. */
+    size_t footprint(const DataPoint& pt) {
+        return sizeof(SpillEntry) + pt.label.size();
+    }
+
+    /* Hands out paths for run files in a private subdirectory of one directory and deletes the
+     * subdirectory, with whatever is still in it, when it is destroyed, so a sort that fails leaves
+     * nothing behind. The subdirectory is made on the first call to create, under a name of the clock
+     * and a random number; create_directory fails rather than reuse a name that exists already, so a
+     * clash with another sort, in this process or any other, just means drawing a new name.
+     */
+    class RunFiles {
+    public:
+        explicit RunFiles(const string& directory) : _next(0) {
+            _parent = directory.empty() ? filesystem::temp_directory_path() : filesystem::path(directory);
+        }
+
+        ~RunFiles() {
+            if (!_directory.empty()) {
+                error_code ignored;
+                filesystem::remove_all(_directory, ignored);
+            }
+        }
+
+        string create() {
+            if (_directory.empty()) {
+                makeDirectory();
+            }
+            return (_directory / (integerToString(_next++) + ".run")).string();
+        }
+
+        void discard(const string& path) {
+            error_code ignored;
+            filesystem::remove(path, ignored);
+        }
+
+    private:
+        void makeDirectory() {
+            random_device entropy;
+            for (int attempt = 0; attempt < 100; attempt++) {
+                string name = "pqsort-" + to_string(chrono::steady_clock::now().time_since_epoch().count())
+                              + "-" + to_string(entropy());
+                filesystem::path candidate = _parent / name;
+                error_code failure;
+                if (filesystem::create_directory(candidate, failure)) {
+                    _directory = candidate;
+                    return;
+                }
+                if (failure) {
+                    error("pqSortExternal: could not create a directory for run files in " + _parent.string());
+                }
+            }
+            error("pqSortExternal: could not find an unused directory name for run files in " + _parent.string());
+        }
+
+        filesystem::path _parent;
+        filesystem::path _directory;    // empty until the first run file is created
+        int _next;
+    };
+
+    /* An open run file and the smallest point in it that has not been merged yet. */
+    struct RunCursor {
+        explicit RunCursor(const string& path) : file(path, ios::binary), reader(file) {
+            if (!file) {
+                error("pqSortExternal: could not reopen run file " + path);
+            }
+            advance();
+        }
+
+        bool advance() {
+            hasHead = reader.read(head);
+            return hasHead;
+        }
+
+        ifstream file;
+        DataPointReader reader;
+        DataPoint head;
+        bool hasHead;
+    };
+
+    /* A run cursor's place in the merge heap: the priority of its head, and which cursor it is. */
+    struct CursorHead {
+        double priority;
+        int cursor;
+    };
+
+    /* Orders cursors by head priority, and equal priorities by cursor, so the merge is deterministic. */
+    struct CursorHeadOrder {
+        bool operator()(const CursorHead& lhs, const CursorHead& rhs) const {
+            if (lhs.priority != rhs.priority) {
+                return lhs.priority < rhs.priority;
+            }
+            return lhs.cursor < rhs.cursor;
+        }
+    };
+
+    /* Opens a fresh run file for writing. */
+    string openRun(RunFiles& files, ofstream& file) {
+        string path = files.create();
+        file.open(path, ios::binary | ios::trunc);
+        if (!file) {
+            error("pqSortExternal: could not create run file " + path);
+        }
+        return path;
+    }
+
+    /* Merges the sorted runs into out with a PQHeap holding one head per run. The cursor whose head
+     * was just written is advanced and, unless its run is used up, goes straight back into the root
+     * slot with replaceTop rather than being dequeued and enqueued again.
+     */
+    void mergeRuns(const vector<string>& runs, DataPointWriter& out) {
+        vector<unique_ptr<RunCursor>> cursors;
+        BasicPQHeap<CursorHead, CursorHeadOrder> heads;
+        for (int i = 0; i < int(runs.size()); i++) {
+            cursors.push_back(make_unique<RunCursor>(runs[i]));
+            if (cursors[i]->hasHead) {
+                heads.enqueue({ cursors[i]->head.priority, i });
+            }
+        }
+
+        while (!heads.isEmpty()) {
+            CursorHead top = heads.peek();
+            RunCursor& cursor = *cursors[top.cursor];
+            out.write(cursor.head);
+            if (cursor.advance()) {
+                top.priority = cursor.head.priority;
+                heads.replaceTop(top);
+            } else {
+                heads.dequeue();
+            }
+        }
+    }
+
+    /* Replacement selection. The heap is filled up to the budget, though it always holds at least one
+     * point. After that, every point written out is replaced by the next input point, tagged for the
+     * current run if it can still follow the point just written and for the next run if not. A run ends
+     * when the heap's smallest point belongs to the next run. If the input runs out before the heap
+     * first fills, the points go straight to out and no runs are returned.
+     */
+    vector<string> formRuns(DataPointReader& in, DataPointWriter& out, size_t budget, RunFiles& files) {
+        BasicPQHeap<SpillEntry, SpillOrder> heap;
+        size_t used = 0;
+        bool more = true;
+        DataPoint pt;
+        while ((used < budget || heap.isEmpty()) && (more = in.read(pt))) {
+            used += footprint(pt);
+            heap.enqueue({ 0, std::move(pt) });
+        }
+        if (!more) {
+            while (!heap.isEmpty()) {
+                out.write(heap.dequeue().point);
+            }
+            return {};
+        }
+
+        vector<string> runs;
+        ofstream file;
+        unique_ptr<DataPointWriter> writer;
+        int currentRun = -1;
+        while (!heap.isEmpty()) {
+            const SpillEntry& smallest = heap.peek();
+            if (smallest.run != currentRun) {
+                if (writer) {
+                    writer->flush();
+                    file.close();
+                }
+                runs.push_back(openRun(files, file));
+                writer = make_unique<DataPointWriter>(file);
+                currentRun = smallest.run;
+            }
+
+            writer->write(smallest.point);
+            double written = smallest.point.priority;
+            used -= footprint(smallest.point);
+            if ((used < budget || heap.size() == 1) && more && (more = in.read(pt))) {
+                int run = pt.priority < written ? currentRun + 1 : currentRun;
+                used += footprint(pt);
+                heap.replaceTop({ run, std::move(pt) });
+            } else {
+                heap.dequeue();
+            }
+        }
+        writer->flush();
+        return runs;
+    }
+}
+
+/*
+ * The budget is split between the two phases in turn: run formation gives all of it, less the two
+ * stream buffers, to the heap, and the merge spends it on one read buffer per run being merged.
+ */
+void pqSortExternal(istream& in, ostream& out, size_t memoryBudget, const string& tempDirectory) {
+    DataPointReader reader(in);
+    DataPointWriter writer(out);
+    RunFiles files(tempDirectory);
+
+    size_t heapBudget = memoryBudget > 2 * kStreamBufferBytes ? memoryBudget - 2 * kStreamBufferBytes : 0;
+    vector<string> runs = formRuns(reader, writer, heapBudget, files);
+
+    size_t fanIn = size_t(clamp(int(min<size_t>(memoryBudget / kStreamBufferBytes, kMaxMergeFanIn + 1)) - 1,
+                                2, kMaxMergeFanIn));
+    while (runs.size() > fanIn) {
+        vector<string> merged;
+        for (size_t first = 0; first < runs.size(); first += fanIn) {
+            vector<string> group(runs.begin() + first, runs.begin() + min(first + fanIn, runs.size()));
+            if (group.size() == 1) {
+                merged.push_back(group[0]);
+                continue;
+            }
+            ofstream file;
+            merged.push_back(openRun(files, file));
+            DataPointWriter groupWriter(file);
+            mergeRuns(group, groupWriter);
+            groupWriter.flush();
+            for (const string& path : group) {
+                files.discard(path);
+            }
+        }
+        runs = std::move(merged);
+    }
+
+    mergeRuns(runs, writer);
+    writer.flush();
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper that encodes points as a binary DataPoint stream. */
+static stringstream asBinary(const Vector<DataPoint>& points) {
+    stringstream result;
+    DataPointWriter writer(result);
+    for (const DataPoint& pt : points) {
+        writer.write(pt);
+    }
+    writer.flush();
+    return result;
+}
+
+/* Helper that decodes a binary DataPoint stream. */
+static Vector<DataPoint> fromBinary(stringstream& stream) {
+    Vector<DataPoint> result;
+    DataPointReader reader(stream);
+    DataPoint pt;
+    while (reader.read(pt)) {
+        result.add(pt);
+    }
+    return result;
+}
+
+/* Helper that sorts points with pqSortExternal in a fresh scratch directory, checks that every run
+ * file was cleaned up afterwards, and returns the sorted points.
+ */
+static Vector<DataPoint> sortExternally(const Vector<DataPoint>& points, size_t budget) {
+    string directory = "pqsort-test-runs";
+    filesystem::create_directory(directory);
+    stringstream in = asBinary(points), out;
+    pqSortExternal(in, out, budget, directory);
+    EXPECT(filesystem::is_empty(directory));
+    filesystem::remove_all(directory);
+    return fromBinary(out);
+}
+
+/* Helper that checks sorted is points in increasing order of priority, every point exactly once. */
+static void expectSortedPermutation(const Vector<DataPoint>& sorted, const Vector<DataPoint>& points) {
+    EXPECT_EQUAL(sorted.size(), points.size());
+    bool inOrder = true;
+    for (int i = 1; i < sorted.size(); i++) {
+        inOrder = inOrder && sorted[i - 1].priority <= sorted[i].priority;
+    }
+    EXPECT(inOrder);
+
+    Vector<int> timesSeen(points.size(), 0);
+    for (const DataPoint& pt : sorted) {
+        int index = stringToInteger(pt.label.substr(pt.label.find('#') + 1));
+        EXPECT_EQUAL(pt, points[index]);
+        timesSeen[index]++;
+    }
+    EXPECT_EQUAL(timesSeen, Vector<int>(points.size(), 1));
+}
+
+STUDENT_TEST("pqSortExternal: sorts with many runs and several merge passes, and cleans up") {
+    Vector<DataPoint> points;
+    for (int i = 0; i < 20000; i++) {
+        points.add({ string(randomInteger(0, 40), 'x') + "#" + integerToString(i), double(randomInteger(0, 5000)) });
+    }
+
+    /* 16 KB leaves almost nothing for the heap and a merge fan-in of 2; 1 MB gives a few long runs. */
+    for (size_t budget : { size_t(0), size_t(16) << 10, size_t(1) << 20 }) {
+        expectSortedPermutation(sortExternally(points, budget), points);
+    }
+}
+
+STUDENT_TEST("pqSortExternal: sorted, reversed, tiny and empty inputs") {
+    Vector<DataPoint> ascending, descending;
+    for (int i = 0; i < 5000; i++) {
+        ascending.add({ "#" + integerToString(i), double(i) });
+        descending.add({ "#" + integerToString(i), double(-i) });
+    }
+    expectSortedPermutation(sortExternally(ascending, 1 << 17), ascending);
+    expectSortedPermutation(sortExternally(descending, 1 << 17), descending);
+
+    Vector<DataPoint> one = { { "#0", 3.5 } };
+    expectSortedPermutation(sortExternally(one, 0), one);
+    expectSortedPermutation(sortExternally(one, 1 << 20), one);
+
+    Vector<DataPoint> none;
+    EXPECT_EQUAL(sortExternally(none, 0).size(), 0);
+}
+
+STUDENT_TEST("pqSortExternal: a truncated stream raises an error and leaves no run files") {
+    Vector<DataPoint> points;
+    for (int i = 0; i < 10000; i++) {
+        points.add({ "#" + integerToString(i), randomReal(0, 1) });
+    }
+    string bytes = asBinary(points).str();
+    stringstream truncated(bytes.substr(0, bytes.size() - 3)), out;
+
+    string directory = "pqsort-test-runs";
+    filesystem::create_directory(directory);
+    EXPECT_ERROR(pqSortExternal(truncated, out, 1 << 17, directory));
+    EXPECT(filesystem::is_empty(directory));
+    filesystem::remove_all(directory);
+}
+
+STUDENT_TEST("pqSortExternal: time against the input size at a fixed 4 MB budget") {
+    for (int n = 250000; n <= 2000000; n *= 2) {
+        Vector<DataPoint> points;
+        for (int i = 0; i < n; i++) {
+            points.add({ "#" + integerToString(i), randomReal(0, 100) });
+        }
+        stringstream in = asBinary(points), out;
+        TIME_OPERATION(n, pqSortExternal(in, out, 4 << 20));
+        EXPECT_EQUAL(fromBinary(out).size(), n);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "datapoint.h"
+#include "datapointstream.h"
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+
+/**
+ * Sorts a binary DataPoint stream (see datapointstream.h) that may be far larger
+ * than memory, writing the points to out in increasing order of priority, also in
+ * the binary format.
+ *
+ * The sort runs in two phases:
+ *
+ *   Run formation  Points are read into a PQHeap until it holds memoryBudget
+ *                  bytes of them. Its smallest point is then written to a
+ *                  temporary run file and replaced by the next input point,
+ *                  which joins the current run if it is not smaller than the
+ *                  point just written and waits for the next run otherwise
+ *                  (replacement selection). Runs come out about twice the size
+ *                  of the budget on random input, and already-sorted input
+ *                  becomes a single run.
+ *   Merge          A PQHeap of run cursors, one per run, repeatedly writes out
+ *                  the smallest head and advances that cursor. If there are too
+ *                  many runs for the budget to give each a read buffer, groups
+ *                  of runs are first merged into longer runs.
+ *
+ * If the whole input fits in the budget no file is written at all. Run files are
+ * created in a new subdirectory of tempDirectory (the system temporary directory
+ * if it is empty), named so that concurrent sorts never share one, and removed
+ * with it before the function returns, including when it fails.
+ *
+ * The budget counts the points held in memory, labels included, plus the stream
+ * buffers; the heap's spare array capacity comes on top of it. If the input is
+ * malformed or a run file cannot be written or read back, this function calls
+ * error().
+ *
+ * @param in A binary DataPoint stream to sort.
+ * @param out The stream the sorted points are written to.
+ * @param memoryBudget Roughly how many bytes the sort may hold in memory at once.
+ * @param tempDirectory Where run files are created.
+ */
+void pqSortExternal(std::istream& in, std::ostream& out, std::size_t memoryBudget,
+                    const std::string& tempDirectory = "");
@@ -0,0 +1,426 @@
+/*
+ * This file, mappeddatapoints, implements the memory-mapped DataPoint file and reader declared in
+ * mappeddatapoints.h, followed by their test cases.
+ */
+#include "mappeddatapoints.h"
+#include "datapointstream.h"
+#include "error.h"
+#include "strlib.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "testsupport.h"
+#include "SimpleTest.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+namespace {
+    /* Longest priority token the text reader accepts; operator<< writes at most about 24 characters. */
+    const size_t kMaxNumberLength = 64;
+
+    /* Value of a single hex digit, or -1 if ch is not one. */
+    int hexValue(char ch) {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        return -1;
+    }
+
+    /* Could ch be part of a number written by operator<<? */
+    bool isNumberChar(char ch) {
+        return isdigit(static_cast<unsigned char>(ch)) || ch == '+' || ch == '-' || ch == '.' || ch == 'e' || ch == 'E';
+    }
+}
+
+/*
+ * Text labels are decoded with the same rules readQuoted in datapoint.cpp uses: \\ and \" stand
+ * for themselves and \xHH for the byte with that hex value. The reader already checked the
+ * escapes, so this only has to translate them.
+ */
+DataPoint materialize(const DataPointView& view) {
+    DataPoint result;
+    result.priority = view.priority;
+    if (!view.escaped) {
+        result.label.assign(view.label.data(), view.label.size());
+        return result;
+    }
+
+    result.label.reserve(view.label.size());
+    for (size_t i = 0; i < view.label.size(); i++) {
+        char ch = view.label[i];
+        if (ch != '\\') {
+            result.label += ch;
+        } else if (view.label[i + 1] == 'x') {
+            result.label += char(hexValue(view.label[i + 2]) * 16 + hexValue(view.label[i + 3]));
+            i += 3;
+        } else {
+            result.label += view.label[i + 1];
+            i += 1;
+        }
+    }
+    return result;
+}
+
+bool labelLess(const DataPointView& lhs, const DataPointView& rhs) {
+    if (!lhs.escaped && !rhs.escaped) {
+        return lhs.label < rhs.label;
+    }
+    return materialize(lhs).label < materialize(rhs).label;
+}
+
+
+/* * * * * * MappedDataPointFile * * * * * */
+
+/*
+ * Opens and maps the whole file read-only. An empty file is not mapped at all (a zero-length
+ * mapping is an error on most systems); it simply has no data.
+ */
+MappedDataPointFile::MappedDataPointFile(const string& path) : _data(nullptr), _size(0), _handle(nullptr) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error("Cannot open DataPoint file " + path);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        error("Cannot determine size of DataPoint file " + path);
+    }
+    _size = size_t(fileSize.QuadPart);
+    if (_size > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            error("Cannot map DataPoint file " + path);
+        }
+        _data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (_data == nullptr) {
+            CloseHandle(mapping);
+            error("Cannot map DataPoint file " + path);
+        }
+        _handle = mapping;
+    } else {
+        CloseHandle(file);
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("Cannot open DataPoint file " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        error("Cannot determine size of DataPoint file " + path);
+    }
+    _size = size_t(info.st_size);
+    if (_size > 0) {
+        void* mapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            error("Cannot map DataPoint file " + path);
+        }
+        madvise(mapped, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const char*>(mapped);
+    }
+    close(fd);  // the mapping keeps the file alive
+#endif
+}
+
+MappedDataPointFile::~MappedDataPointFile() {
+#ifdef _WIN32
+    if (_data != nullptr) {
+        UnmapViewOfFile(_data);
+        CloseHandle(static_cast<HANDLE>(_handle));
+    }
+#else
+    if (_data != nullptr) {
+        munmap(const_cast<char*>(_data), _size);
+    }
+#endif
+}
+
+bool MappedDataPointFile::isBinary() const {
+    return _size >= sizeof(kDataPointStreamMagic) &&
+           memcmp(_data, kDataPointStreamMagic, sizeof(kDataPointStreamMagic)) == 0;
+}
+
+const char* MappedDataPointFile::data() const {
+    return _data;
+}
+
+size_t MappedDataPointFile::size() const {
+    return _size;
+}
+
+
+/* * * * * * MappedDataPointReader * * * * * */
+
+MappedDataPointReader::MappedDataPointReader(const MappedDataPointFile& file) :
+    MappedDataPointReader(file, file.isBinary() ? sizeof(kDataPointStreamMagic) : 0, file.size()) {
+}
+
+MappedDataPointReader::MappedDataPointReader(const MappedDataPointFile& file, size_t begin, size_t end) :
+    _base(file.data()), _pos(file.data() + begin), _stop(file.data() + end),
+    _end(file.data() + file.size()), _binary(file.isBinary()) {
+    if (begin > end || end > file.size()) {
+        error("MappedDataPointReader: invalid byte range!");
+    }
+}
+
+size_t MappedDataPointReader::position() const {
+    return size_t(_pos - _base);
+}
+
+bool MappedDataPointReader::read(DataPointView& result) {
+    return _binary ? readBinary(result) : readText(result);
+}
+
+/*
+ * A binary record is decoded in place: the label view covers the label bytes in the mapping.
+ */
+bool MappedDataPointReader::readBinary(DataPointView& result) {
+    if (_pos >= _stop) {
+        return false;
+    }
+    size_t remaining = size_t(_end - _pos);
+    if (remaining < kDataPointRecordOverhead) {
+        error("MappedDataPointReader: file ends inside a binary record!");
+    }
+    size_t length = decodeRecordLength(_pos);
+    if (remaining - kDataPointRecordOverhead < length) {
+        error("MappedDataPointReader: file ends inside a binary record!");
+    }
+
+    result.label = string_view(_pos + 4, length);
+    result.priority = decodeRecordPriority(_pos + 4 + length);
+    result.escaped = false;
+    _pos += kDataPointRecordOverhead + length;
+    return true;
+}
+
+/*
+ * Parses one { "label", priority } record with the same grammar operator>> accepts. The label
+ * view covers the raw text between the quotes; escapes are validated here and decoded later,
+ * only for the labels that are actually materialized.
+ */
+bool MappedDataPointReader::readText(DataPointView& result) {
+    const char* p = _pos;
+    auto skipSpace = [&] {
+        while (p < _end && isspace(static_cast<unsigned char>(*p))) p++;
+    };
+    auto expect = [&](char ch) {
+        skipSpace();
+        if (p == _end || *p != ch) {
+            error(string("MappedDataPointReader: expected '") + ch + "' in DataPoint text");
+        }
+        p++;
+    };
+
+    skipSpace();
+    if (p >= _stop) {
+        _pos = p;
+        return false;
+    }
+    expect('{');
+    expect('"');
+
+    /* Scan the label up to its closing quote, checking escapes as we go. */
+    const char* labelStart = p;
+    bool escaped = false;
+    while (true) {
+        if (p == _end) {
+            error("MappedDataPointReader: file ends inside a DataPoint label!");
+        }
+        if (*p == '"') {
+            break;
+        }
+        if (*p == '\\') {
+            escaped = true;
+            if (_end - p >= 2 && (p[1] == '\\' || p[1] == '"')) {
+                p += 2;
+            } else if (_end - p >= 4 && p[1] == 'x' && hexValue(p[2]) >= 0 && hexValue(p[3]) >= 0) {
+                p += 4;
+            } else {
+                error("MappedDataPointReader: invalid escape in DataPoint label!");
+            }
+        } else {
+            p++;
+        }
+    }
+    result.label = string_view(labelStart, size_t(p - labelStart));
+    result.escaped = escaped;
+    p++;    // closing quote
+
+    expect(',');
+    skipSpace();
+
+    /* strtod needs a terminated string, and the mapping is not one, so the token is copied out. */
+    char number[kMaxNumberLength + 1];
+    size_t length = 0;
+    while (p < _end && isNumberChar(*p) && length < kMaxNumberLength) {
+        number[length++] = *p++;
+    }
+    number[length] = '\0';
+    char* numberEnd;
+    result.priority = strtod(number, &numberEnd);
+    if (length == 0 || numberEnd != number + length) {
+        error("MappedDataPointReader: invalid priority in DataPoint text!");
+    }
+
+    expect('}');
+    _pos = p;
+    return true;
+}
+
+
+/*
+ * Binary boundaries come from walking the chain of length prefixes, which touches each record once
+ * but decodes nothing else. Text boundaries are found by a forward scan from each even split point.
+ */
+vector<size_t> splitDataPointFile(const MappedDataPointFile& file, int parts) {
+    if (parts < 1) {
+        error("splitDataPointFile: parts must be at least 1!");
+    }
+    const char* data = file.data();
+    size_t size = file.size();
+    size_t first = file.isBinary() ? sizeof(kDataPointStreamMagic) : 0;
+
+    vector<size_t> boundaries(parts + 1, size);
+    boundaries[0] = first;
+
+    if (file.isBinary()) {
+        size_t offset = first;
+        int next = 1;
+        while (offset < size && next < parts) {
+            size_t target = first + (size - first) / parts * next;
+            if (offset >= target) {
+                boundaries[next++] = offset;
+                continue;
+            }
+            if (size - offset < kDataPointRecordOverhead) {
+                break;
+            }
+            offset += kDataPointRecordOverhead + decodeRecordLength(data + offset);
+        }
+        for (; next < parts; next++) {
+            boundaries[next] = min(offset, size);
+        }
+    } else {
+        for (int i = 1; i < parts; i++) {
+            size_t offset = max(boundaries[i - 1], size / parts * i);
+            for (; offset + 1 < size; offset++) {
+                if (data[offset] != '{' || data[offset + 1] != '"') continue;
+                size_t before = offset;
+                while (before > 0 && isspace(static_cast<unsigned char>(data[before - 1]))) before--;
+                if (before > 0 && data[before - 1] == '}') break;
+            }
+            boundaries[i] = offset + 1 < size ? offset : size;
+        }
+    }
+    return boundaries;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("MappedDataPointReader: text and binary files give views of every record") {
+    Vector<DataPoint> points = {
+        { "plain", 1 },
+        { "quote \" and slash \\", -2.5 },
+        { "\x01 control", 1e10 },
+        { "", 0 },
+    };
+
+    for (bool binary : { false, true }) {
+        string path = writeScratchFile("mapped-datapoints-test", points, binary);
+        {
+            MappedDataPointFile file(path);
+            EXPECT_EQUAL(file.isBinary(), binary);
+            MappedDataPointReader reader(file);
+            DataPointView view;
+            Vector<DataPoint> read;
+            while (reader.read(view)) {
+                read.add(materialize(view));
+            }
+            EXPECT_EQUAL(read, points);
+        }
+        remove(path.c_str());
+    }
+}
+
+STUDENT_TEST("MappedDataPointReader: unescaped text labels point into the mapping") {
+    string path = writeScratchFile("mapped-datapoints-test", { { "slice", 3 } }, false);
+    {
+        MappedDataPointFile file(path);
+        MappedDataPointReader reader(file);
+        DataPointView view;
+        EXPECT(reader.read(view));
+        EXPECT(!view.escaped);
+        EXPECT(view.label.data() > file.data() && view.label.data() < file.data() + file.size());
+        EXPECT_EQUAL(string(view.label), "slice");
+        EXPECT(!reader.read(view));
+    }
+    remove(path.c_str());
+}
+
+STUDENT_TEST("MappedDataPointFile: empty, missing and malformed files") {
+    string path = writeScratchFile("mapped-datapoints-test", {}, false);
+    {
+        MappedDataPointFile file(path);
+        MappedDataPointReader reader(file);
+        DataPointView view;
+        EXPECT(!reader.read(view));
+    }
+    {
+        ofstream out(path, ios::trunc);
+        out << "{\"unterminated, 1}";
+    }
+    {
+        MappedDataPointFile file(path);
+        MappedDataPointReader reader(file);
+        DataPointView view;
+        EXPECT_ERROR(reader.read(view));
+    }
+    remove(path.c_str());
+    EXPECT_ERROR(MappedDataPointFile missing("no-such-datapoint-file.txt"));
+}
+
+STUDENT_TEST("splitDataPointFile: range readers together see every record exactly once") {
+    Vector<DataPoint> points;
+    for (int i = 0; i < 1000; i++) {
+        points.add({ "label }{ " + integerToString(i), double(i % 17) });
+    }
+
+    for (bool binary : { false, true }) {
+        string path = writeScratchFile("mapped-datapoints-test", points, binary);
+        {
+            MappedDataPointFile file(path);
+            for (int parts : { 1, 2, 3, 8, 2000 }) {
+                vector<size_t> boundaries = splitDataPointFile(file, parts);
+                EXPECT_EQUAL(int(boundaries.size()), parts + 1);
+                Vector<DataPoint> read;
+                for (int i = 0; i < parts; i++) {
+                    MappedDataPointReader reader(file, boundaries[i], boundaries[i + 1]);
+                    DataPointView view;
+                    while (reader.read(view)) {
+                        read.add(materialize(view));
+                    }
+                    EXPECT_EQUAL(reader.position(), boundaries[i + 1]);
+                }
+                EXPECT_EQUAL(read, points);
+            }
+        }
+        remove(path.c_str());
+    }
+}
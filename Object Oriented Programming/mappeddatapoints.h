@@ -0,0 +1,136 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A DataPoint whose label is not owned: it is a slice of a memory-mapped file.
+ *
+ * For binary files the slice is the exact label. For text files it is the text
+ * between the quotes as it appears in the file, so if escaped is true it still
+ * contains backslash escapes that materialize() decodes.
+ *
+ * A view is only valid while the MappedDataPointFile it came from is alive.
+ */
+struct DataPointView {
+    std::string_view label;
+    double priority;
+    bool escaped;
+};
+
+/**
+ * Copies a view into an ordinary DataPoint, decoding any text-format escapes in
+ * its label. This is the only place a label is copied out of the mapping.
+ */
+DataPoint materialize(const DataPointView& view);
+
+/**
+ * Returns whether lhs's label sorts before rhs's, comparing the decoded labels
+ * that materialize() would produce, so views order exactly like DataPoints.
+ * Only labels that still contain escapes are decoded to compare them.
+ */
+bool labelLess(const DataPointView& lhs, const DataPointView& rhs);
+
+/**
+ * Read-only memory mapping of a file of DataPoints, in either the text format
+ * written by operator<< or the binary format of datapointstream.h (recognized by
+ * its magic bytes). The file is never read through a stream: pages are brought
+ * in by the operating system as the reader touches them.
+ */
+class MappedDataPointFile {
+public:
+    /**
+     * Maps the file at path. If it cannot be opened or mapped, this function
+     * calls error().
+     */
+    explicit MappedDataPointFile(const std::string& path);
+
+    /**
+     * Unmaps the file. Every DataPointView taken from it becomes invalid.
+     */
+    ~MappedDataPointFile();
+
+    /**
+     * Returns whether the file is in the binary DataPoint format.
+     */
+    bool isBinary() const;
+
+    /**
+     * Returns the mapped bytes and their count.
+     */
+    const char* data() const;
+    std::size_t size() const;
+
+private:
+    const char* _data;      // start of the mapping, nullptr for an empty file
+    std::size_t _size;      // length of the file in bytes
+    void* _handle;          // platform mapping handle (Windows only)
+
+    DISALLOW_COPYING_OF(MappedDataPointFile);
+};
+
+/**
+ * Walks the records of a MappedDataPointFile in order, producing DataPointViews
+ * that point straight into the mapping. No label is copied or allocated.
+ */
+class MappedDataPointReader {
+public:
+    /**
+     * Creates a reader positioned at the first record of file.
+     */
+    explicit MappedDataPointReader(const MappedDataPointFile& file);
+
+    /**
+     * Creates a reader over just the records of file that start at byte offsets
+     * in [begin, end). begin must be the offset of a record (or of whitespace
+     * before one), such as a boundary from splitDataPointFile.
+     */
+    MappedDataPointReader(const MappedDataPointFile& file, std::size_t begin, std::size_t end);
+
+    /**
+     * Reads the next record into result. Returns false once only whitespace
+     * (text) or nothing (binary) is left. If the data is malformed, this
+     * function calls error().
+     *
+     * Usage mirrors the stream formats:  while (reader.read(view)) { ... }
+     */
+    bool read(DataPointView& result);
+
+    /**
+     * Returns the byte offset in the file of the next unread record. Once read
+     * has returned false this is the start of the first record at or past the
+     * end of the reader's range, or the size of the file.
+     */
+    std::size_t position() const;
+
+private:
+    bool readText(DataPointView& result);
+    bool readBinary(DataPointView& result);
+
+    const char* _base;      // start of the mapping
+    const char* _pos;       // next unread byte
+    const char* _stop;      // records starting at or past here are out of range
+    const char* _end;       // one past the last mapped byte
+    bool _binary;           // format of the file
+
+    DISALLOW_COPYING_OF(MappedDataPointReader);
+};
+
+/**
+ * Splits file into parts byte ranges of roughly equal size whose boundaries fall
+ * on record starts, so that each range can be read by its own reader in parallel.
+ * Returns parts + 1 nondecreasing offsets; range i is [result[i], result[i+1]).
+ *
+ * For binary files the boundaries are exact, found by hopping from one length
+ * prefix to the next. The format has no marker to resynchronize on, so that walk
+ * visits every record, on the calling thread, in time O(number of records): it
+ * is a serial phase ahead of any parallel scan of the ranges. Text has no framing that cannot also occur inside a label,
+ * so for text files each boundary is the first '{' followed by '"' and preceded
+ * by '}' after the even split point, which is right for any realistic label but
+ * not guaranteed. A caller can confirm a text split by checking that the reader
+ * for range i stops at exactly result[i+1] (see MappedDataPointReader::position).
+ */
+std::vector<std::size_t> splitDataPointFile(const MappedDataPointFile& file, int parts);
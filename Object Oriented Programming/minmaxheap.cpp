@@ -0,0 +1,163 @@
+/*
+ * This file, minmaxheap, holds the test cases for the MinMaxHeap class template defined in minmaxheap.h,
+ * and a time trial against PQHeap and BoundedTopK.
+ */
+#include "minmaxheap.h"
+#include "boundedtopk.h"
+#include "pqheap.h"
+#include "random.h"
+#include "strlib.h"
+#include "testsupport.h"
+#include "SimpleTest.h"
+#include <algorithm>
+#include <set>
+#include <vector>
+using namespace std;
+
+template class MinMaxHeap<DataPoint>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("MinMaxHeap: example from PQHeap writeup, from both ends") {
+    MinMaxHeap<DataPoint> pq;
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.dequeueMin());
+    EXPECT_ERROR(pq.dequeueMax());
+    EXPECT_ERROR(pq.peekMin());
+    EXPECT_ERROR(pq.peekMax());
+    EXPECT_ERROR(pq.replaceMin({"", 1}));
+
+    Vector<DataPoint> input = {
+        {"R", 4}, {"A", 5}, {"B", 3}, {"K", 7}, {"G", 2},
+        {"V", 9}, {"T", 1}, {"O", 8}, {"S", 6} };
+    for (const DataPoint& dp : input) {
+        pq.enqueue(dp);
+    }
+    EXPECT_EQUAL(pq.size(), 9);
+    EXPECT_EQUAL(pq.peekMin(), {"T", 1});
+    EXPECT_EQUAL(pq.peekMax(), {"V", 9});
+
+    EXPECT_EQUAL(pq.dequeueMax(), {"V", 9});
+    EXPECT_EQUAL(pq.dequeueMin(), {"T", 1});
+    EXPECT_EQUAL(pq.dequeueMax(), {"O", 8});
+    EXPECT_EQUAL(pq.replaceMin({"Z", 10}), {"G", 2});
+    EXPECT_EQUAL(pq.peekMax(), {"Z", 10});
+    EXPECT_EQUAL(pq.replaceMax({"Y", 0}), {"Z", 10});
+    EXPECT_EQUAL(pq.peekMin(), {"Y", 0});
+    for (int priority : {0, 3, 4, 5, 6, 7}) {
+        EXPECT_EQUAL(pq.dequeueMin().priority, priority);
+    }
+    EXPECT(pq.isEmpty());
+
+    pq.enqueue({"only", 1});
+    EXPECT_EQUAL(pq.peekMax(), {"only", 1});
+    EXPECT_EQUAL(pq.replaceMax({"other", 2}), {"only", 1});
+    pq.clear();
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("MinMaxHeap: stress test against a multiset, dequeueing from both ends") {
+    setRandomSeed(24);
+    MinMaxHeap<DataPoint> pq;
+    multiset<double> reference;
+    for (int i = 0; i < 50000; i++) {
+        int choice = randomInteger(0, 9);
+        if (choice < 5 || reference.empty()) {
+            double priority = randomInteger(0, 500);                  // plenty of ties
+            pq.enqueue({"", priority});
+            reference.insert(priority);
+        } else if (choice < 7) {
+            EXPECT_EQUAL(pq.dequeueMin().priority, *reference.begin());
+            reference.erase(reference.begin());
+        } else if (choice < 9) {
+            EXPECT_EQUAL(pq.dequeueMax().priority, *reference.rbegin());
+            reference.erase(prev(reference.end()));
+        } else {
+            double priority = randomInteger(0, 500);
+            if (randomChance(0.5)) {
+                EXPECT_EQUAL(pq.replaceMin({"", priority}).priority, *reference.begin());
+                reference.erase(reference.begin());
+            } else {
+                EXPECT_EQUAL(pq.replaceMax({"", priority}).priority, *reference.rbegin());
+                reference.erase(prev(reference.end()));
+            }
+            reference.insert(priority);
+        }
+        EXPECT_EQUAL(pq.size(), int(reference.size()));
+        if (!reference.empty()) {
+            EXPECT_EQUAL(pq.peekMin().priority, *reference.begin());
+            EXPECT_EQUAL(pq.peekMax().priority, *reference.rbegin());
+        }
+    }
+}
+
+STUDENT_TEST("MinMaxHeap: bounded top-k by replaceMin matches BoundedTopK, with the best one at peekMax") {
+    int k = 25;
+    MinMaxHeap<DataPoint> kept;
+    BoundedTopK<DataPoint> reference(k);
+    for (int i = 0; i < 10000; i++) {
+        DataPoint pt = {"", randomReal(-100, 100)};
+        reference.offer(pt);
+        if (kept.size() < k) {
+            kept.enqueue(pt);
+        } else if (kept.peekMin().priority < pt.priority) {
+            kept.replaceMin(std::move(pt));
+        }
+        EXPECT_EQUAL(kept.peekMin(), reference.weakest());
+    }
+    Vector<DataPoint> best = reference.takeDescending();
+    for (int i = 0; i < k; i++) {
+        EXPECT_EQUAL(kept.dequeueMax(), best[i]);
+    }
+}
+
+/* Finds the k lowest and the k highest points with one MinMaxHeap. */
+static void bothEndsOnce(const Vector<DataPoint>& input, int k, Vector<DataPoint>& lowest, Vector<DataPoint>& highest) {
+    MinMaxHeap<DataPoint> pq;
+    for (const DataPoint& pt : input) {
+        pq.enqueue(pt);
+    }
+    lowest.clear();
+    highest.clear();
+    for (int i = 0; i < k; i++) {
+        lowest.add(pq.dequeueMin());
+        highest.add(pq.dequeueMax());
+    }
+}
+
+/* Finds the same with two BoundedTopK passes, the second with the comparison turned around. */
+static void bothEndsTwice(const Vector<DataPoint>& input, int k, Vector<DataPoint>& lowest, Vector<DataPoint>& highest) {
+    auto higherFirst = [](const DataPoint& lhs, const DataPoint& rhs) { return lhs.priority > rhs.priority; };
+    BoundedTopK<DataPoint> high(k);
+    BoundedTopK<DataPoint, decltype(higherFirst)> low(k, higherFirst);
+    for (const DataPoint& pt : input) {
+        high.offer(pt);
+    }
+    for (const DataPoint& pt : input) {
+        low.offer(pt);
+    }
+    highest = high.takeDescending();
+    lowest = low.takeDescending();
+}
+
+STUDENT_TEST("MinMaxHeap: time against PQHeap, and both ends of a ranking against two BoundedTopK passes") {
+    for (int n = 100000; n <= 1000000; n *= 10) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"", randomReal(0, 10)});
+        }
+        MinMaxHeap<DataPoint> minMax;
+        PQHeap heap;
+        TIME_OPERATION(n, fillThenDrain(minMax, input));
+        TIME_OPERATION(n, fillThenDrain(heap, input));
+
+        Vector<DataPoint> lowOnce, highOnce, lowTwice, highTwice;
+        TIME_OPERATION(n, bothEndsOnce(input, 10, lowOnce, highOnce));
+        TIME_OPERATION(n, bothEndsTwice(input, 10, lowTwice, highTwice));
+        for (int i = 0; i < 10; i++) {
+            EXPECT_EQUAL(lowOnce[i].priority, lowTwice[i].priority);
+            EXPECT_EQUAL(highOnce[i].priority, highTwice[i].priority);
+        }
+    }
+}
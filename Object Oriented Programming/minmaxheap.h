@@ -0,0 +1,305 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include <utility>
+#include <vector>
+
+/**
+ * Double-ended priority queue implemented as a min-max heap.
+ *
+ * The array is laid out like a binary heap, but the levels alternate: an
+ * element on an even level (the root's, then every other one below) is the
+ * minimum of its subtree and an element on an odd level is the maximum of its
+ * subtree. The minimum is therefore the root and the maximum is one of the
+ * root's two children, so both peeks run in time O(1), and enqueue and either
+ * dequeue move an element along a path of grandparents or grandchildren, which
+ * takes time O(log n).
+ *
+ * One queue can serve both ends of a ranking: the lowest k and the highest k
+ * of a data set come out of the same structure, with no negating of
+ * priorities to turn one end into the other, and it stays live as elements
+ * come and go. (For a one-off selection over a fixed data set, two BoundedTopK
+ * passes that keep only k elements each are several times faster.) For a
+ * bounded top-k, replaceMin evicts the weakest survivor and seats a new one in
+ * a single walk while peekMax still names the best.
+ *
+ * T and Compare are as for BasicPQHeap: compare(a, b) returns true when a
+ * comes before b, so the "min" end is the one BasicPQHeap would dequeue first.
+ * Elements that compare equal are dequeued in arbitrary order.
+ */
+template <typename T = DataPoint, typename Compare = LowerPriorityFirst>
+class MinMaxHeap {
+public:
+    /**
+     * Creates a new, empty priority queue that orders elements using compare.
+     */
+    explicit MinMaxHeap(Compare compare = Compare());
+
+    /**
+     * Adds a new element into the queue. This operation runs in time
+     * O(log n).
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Returns, but does not remove, the element at the min or the max end of
+     * the queue. If the queue is empty, these functions call error(). These
+     * operations run in time O(1).
+     */
+    const T& peekMin() const;
+    const T& peekMax() const;
+
+    /**
+     * Removes and returns the element at the min or the max end of the queue.
+     * If the queue is empty, these functions call error(). These operations
+     * run in time O(log n).
+     */
+    T dequeueMin();
+    T dequeueMax();
+
+    /**
+     * Removes and returns the element at the min or the max end of the queue
+     * and adds element in its place, in one walk down the heap instead of a
+     * dequeue and an enqueue. If the queue is empty, these functions call
+     * error(). These operations run in time O(log n).
+     */
+    T replaceMin(T&& element);
+    T replaceMax(T&& element);
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue.
+     */
+    void clear();
+
+private:
+    static bool isMinLevel(int index);  // whether index is on an even level of the heap
+    int maxIndex() const;               // where the max is: the root or the larger of its children
+
+    /* Whether a belongs above b on a level of the given kind: before it on a min level, after it on a
+     * max level. */
+    bool above(const T& a, const T& b, bool minLevel) const;
+
+    void percolateUp(int hole, T&& element);    // fills the new hole at the end of the array with element
+    void trickleDown(int hole, T&& element);    // fills hole, whose subtree is otherwise in order, with element
+
+    std::vector<T> _elements;
+    Compare _compare;           // compare(a, b) is true when a is nearer the min end than b
+
+    DISALLOW_COPYING_OF(MinMaxHeap);
+};
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+template <typename T, typename Compare>
+MinMaxHeap<T, Compare>::MinMaxHeap(Compare compare) : _compare(std::move(compare)) {}
+
+template <typename T, typename Compare>
+void MinMaxHeap<T, Compare>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+template <typename T, typename Compare>
+void MinMaxHeap<T, Compare>::enqueue(T&& element) {
+    _elements.emplace_back();
+    percolateUp(size() - 1, std::move(element));
+}
+
+template <typename T, typename Compare>
+const T& MinMaxHeap<T, Compare>::peekMin() const {
+    if (isEmpty()) {
+        error("Cannot peek because MinMaxHeap is empty!");
+    }
+    return _elements[0];
+}
+
+template <typename T, typename Compare>
+const T& MinMaxHeap<T, Compare>::peekMax() const {
+    if (isEmpty()) {
+        error("Cannot peek because MinMaxHeap is empty!");
+    }
+    return _elements[maxIndex()];
+}
+
+/*
+ * The last element is taken out and trickled down from the vacated slot, as in a binary heap.
+ */
+template <typename T, typename Compare>
+T MinMaxHeap<T, Compare>::dequeueMin() {
+    if (isEmpty()) {
+        error("Cannot dequeue because MinMaxHeap is empty!");
+    }
+    T result = std::move(_elements[0]);
+    T last = std::move(_elements.back());
+    _elements.pop_back();
+    if (!isEmpty()) {
+        trickleDown(0, std::move(last));
+    }
+    return result;
+}
+
+template <typename T, typename Compare>
+T MinMaxHeap<T, Compare>::dequeueMax() {
+    if (isEmpty()) {
+        error("Cannot dequeue because MinMaxHeap is empty!");
+    }
+    int hole = maxIndex();
+    T result = std::move(_elements[hole]);
+    T last = std::move(_elements.back());
+    _elements.pop_back();
+    if (hole < size()) {
+        trickleDown(hole, std::move(last));
+    }
+    return result;
+}
+
+template <typename T, typename Compare>
+T MinMaxHeap<T, Compare>::replaceMin(T&& element) {
+    if (isEmpty()) {
+        error("Cannot replace in MinMaxHeap because it is empty!");
+    }
+    T result = std::move(_elements[0]);
+    trickleDown(0, std::move(element));
+    return result;
+}
+
+/*
+ * The max slot's parent is the root, so the new element first trades places with the root if it belongs
+ * at the min end, and what is left goes down from the max slot.
+ */
+template <typename T, typename Compare>
+T MinMaxHeap<T, Compare>::replaceMax(T&& element) {
+    if (isEmpty()) {
+        error("Cannot replace in MinMaxHeap because it is empty!");
+    }
+    int hole = maxIndex();
+    T result = std::move(_elements[hole]);
+    if (hole > 0 && _compare(element, _elements[0])) {
+        std::swap(element, _elements[0]);
+    }
+    trickleDown(hole, std::move(element));
+    return result;
+}
+
+template <typename T, typename Compare>
+bool MinMaxHeap<T, Compare>::isEmpty() const {
+    return _elements.empty();
+}
+
+template <typename T, typename Compare>
+int MinMaxHeap<T, Compare>::size() const {
+    return int(_elements.size());
+}
+
+template <typename T, typename Compare>
+void MinMaxHeap<T, Compare>::clear() {
+    _elements.clear();
+}
+
+template <typename T, typename Compare>
+bool MinMaxHeap<T, Compare>::isMinLevel(int index) {
+    int level = 0;
+    for (unsigned position = unsigned(index) + 1; position > 1; position >>= 1) {
+        level++;
+    }
+    return level % 2 == 0;
+}
+
+template <typename T, typename Compare>
+int MinMaxHeap<T, Compare>::maxIndex() const {
+    if (size() <= 2) {
+        return size() - 1;
+    }
+    return _compare(_elements[1], _elements[2]) ? 2 : 1;
+}
+
+template <typename T, typename Compare>
+bool MinMaxHeap<T, Compare>::above(const T& a, const T& b, bool minLevel) const {
+    return minLevel ? _compare(a, b) : _compare(b, a);
+}
+
+/*
+ * The new element is first checked against its parent, which is on the other kind of level: if it belongs
+ * above the parent, the parent moves down into the hole and the element carries on from the parent's slot.
+ * From there it only has to pass grandparents, which are on its own kind of level.
+ */
+template <typename T, typename Compare>
+void MinMaxHeap<T, Compare>::percolateUp(int hole, T&& element) {
+    if (hole > 0) {
+        bool minLevel = isMinLevel(hole);
+        int parent = (hole - 1) / 2;
+        if (above(element, _elements[parent], !minLevel)) {
+            _elements[hole] = std::move(_elements[parent]);
+            hole = parent;
+            minLevel = !minLevel;
+        }
+        while (hole >= 3) {
+            int grandparent = (hole - 3) / 4;
+            if (!above(element, _elements[grandparent], minLevel)) {
+                break;
+            }
+            _elements[hole] = std::move(_elements[grandparent]);
+            hole = grandparent;
+        }
+    }
+    _elements[hole] = std::move(element);
+}
+
+/*
+ * At each step the most extreme of the hole's children and grandchildren, for the hole's kind of level,
+ * is found, grandchildren winning ties. If that is a grandchild that belongs above the element, it moves
+ * up into the hole and the element goes on from the grandchild's slot, first trading places with the
+ * parent in between if it belongs above that one. If it is a child, it has no children of its own (a
+ * child with children can only tie them, and loses the tie), so one exchange at most finishes the walk.
+ */
+template <typename T, typename Compare>
+void MinMaxHeap<T, Compare>::trickleDown(int hole, T&& element) {
+    bool minLevel = isMinLevel(hole);
+    while (true) {
+        int child = 2 * hole + 1;
+        if (child >= size()) {
+            break;
+        }
+        int best = child;
+        if (child + 1 < size() && above(_elements[child + 1], _elements[best], minLevel)) {
+            best = child + 1;
+        }
+        int firstGrandchild = 4 * hole + 3;
+        for (int g = firstGrandchild; g < firstGrandchild + 4 && g < size(); g++) {
+            if (!above(_elements[best], _elements[g], minLevel)) {
+                best = g;
+            }
+        }
+
+        if (best < firstGrandchild) {
+            if (above(_elements[best], element, minLevel)) {
+                _elements[hole] = std::move(_elements[best]);
+                hole = best;
+            }
+            break;
+        }
+        if (!above(_elements[best], element, minLevel)) {
+            break;
+        }
+        _elements[hole] = std::move(_elements[best]);
+        hole = best;
+        int parent = (best - 1) / 2;
+        if (above(element, _elements[parent], !minLevel)) {
+            std::swap(element, _elements[parent]);
+        }
+    }
+    _elements[hole] = std::move(element);
+}
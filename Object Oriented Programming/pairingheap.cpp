@@ -0,0 +1,170 @@
+/*
+ * This file, pairingheap, holds the test cases for the PairingHeap class template defined in pairingheap.h,
+ * and time trials against PQHeap on enqueue-heavy and merge-heavy workloads.
+ */
+#include "pairingheap.h"
+#include "pqheap.h"
+#include "random.h"
+#include "testsupport.h"
+#include "SimpleTest.h"
+#include <functional>
+#include <memory>
+using namespace std;
+
+template class PairingHeap<DataPoint>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("PairingHeap: example from PQHeap writeup") {
+    PairingHeap<DataPoint> pq;
+    Vector<DataPoint> input = {
+        {"R", 4}, {"A", 5}, {"B", 3}, {"K", 7}, {"G", 2},
+        {"V", 9}, {"T", 1}, {"O", 8}, {"S", 6} };
+    for (const DataPoint& dp : input) {
+        pq.enqueue(dp);
+        pq.debugConfirmHeapOrder();
+    }
+    EXPECT_EQUAL(pq.size(), 9);
+    EXPECT_EQUAL(pq.peek(), {"T", 1});
+
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.debugConfirmHeapOrder();
+    }
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("PairingHeap: stress test against PQHeap, with melds of random shards") {
+    setRandomSeed(7);
+    PQHeap reference;
+    PairingHeap<DataPoint> pq;
+
+    for (int i = 0; i < 20000; i++) {
+        double r = randomReal(0, 1);
+        if (r < 0.6 || reference.isEmpty()) {
+            DataPoint elem = {"", double(randomInteger(-100, 100))};
+            reference.enqueue(elem);
+            pq.enqueue(elem);
+        } else if (r < 0.62) {
+            PairingHeap<DataPoint> shard;
+            for (int j = randomInteger(0, 50); j > 0; j--) {
+                DataPoint elem = {"", double(randomInteger(-100, 100))};
+                reference.enqueue(elem);
+                shard.enqueue(elem);
+            }
+            pq.meld(shard);
+            EXPECT(shard.isEmpty());
+            shard.enqueue({"", 0});     // the emptied shard is still usable
+            EXPECT_EQUAL(shard.dequeue().priority, 0);
+        } else {
+            double expected = reference.dequeue().priority;
+            EXPECT_EQUAL(pq.dequeue().priority, expected);
+        }
+        EXPECT_EQUAL(pq.size(), reference.size());
+    }
+    pq.debugConfirmHeapOrder();
+
+    pq.meld(pq);
+    EXPECT_EQUAL(pq.size(), reference.size());
+    pq.clear();
+    EXPECT(pq.isEmpty());
+    pq.enqueue({"after clear", 3});
+    EXPECT_EQUAL(pq.peek().priority, 3);
+}
+
+STUDENT_TEST("PairingHeap: melded nodes outlive the heap they came from") {
+    PairingHeap<unique_ptr<int>, function<bool(const unique_ptr<int>&, const unique_ptr<int>&)>> pq(
+        [](const unique_ptr<int>& a, const unique_ptr<int>& b) { return *a < *b; });
+    for (int shard = 0; shard < 10; shard++) {
+        PairingHeap<unique_ptr<int>, function<bool(const unique_ptr<int>&, const unique_ptr<int>&)>> other(
+            [](const unique_ptr<int>& a, const unique_ptr<int>& b) { return *a < *b; });
+        for (int i = 0; i < 100; i++) {
+            other.enqueue(make_unique<int>(i * 10 + shard));
+        }
+        other.dequeue();            // leaves a free node behind to be handed over too
+        pq.meld(other);
+    }                               // each shard is destroyed here, after giving up its pool
+
+    for (int i = 0; i < 10; i++) {
+        pq.enqueue(make_unique<int>(-1 - i));
+    }
+    pq.debugConfirmHeapOrder();
+    EXPECT_EQUAL(pq.size(), 1000);
+    for (int i = 10; i >= 1; i--) {
+        unique_ptr<int> front = pq.dequeue();
+        EXPECT_EQUAL(*front, -i);
+    }
+    int previous = -1;
+    while (!pq.isEmpty()) {
+        unique_ptr<int> front = pq.dequeue();
+        EXPECT(*front > previous);
+        previous = *front;
+    }
+}
+
+/* Merge-heavy: numShards shards are built separately, and then the timed step combines them into
+ * one queue. With PQHeap that means draining every shard into the combined queue; with PairingHeap
+ * each shard is a single meld. Returns the combined queue's size.
+ */
+static int combineShards(vector<unique_ptr<PQHeap>>& shards) {
+    PQHeap combined;
+    for (auto& shard : shards) {
+        while (!shard->isEmpty()) {
+            combined.enqueue(shard->dequeue());
+        }
+    }
+    return combined.size();
+}
+
+static int combineShards(vector<unique_ptr<PairingHeap<DataPoint>>>& shards) {
+    PairingHeap<DataPoint> combined;
+    for (auto& shard : shards) {
+        combined.meld(*shard);
+    }
+    return combined.size();
+}
+
+template <typename Queue>
+vector<unique_ptr<Queue>> buildShards(const Vector<Vector<double>>& priorities) {
+    vector<unique_ptr<Queue>> shards;
+    for (const Vector<double>& shardPriorities : priorities) {
+        shards.push_back(make_unique<Queue>());
+        for (double p : shardPriorities) {
+            shards.back()->enqueue({"", p});
+        }
+    }
+    return shards;
+}
+
+STUDENT_TEST("PairingHeap: time against PQHeap on enqueue-heavy and merge-heavy workloads") {
+    for (int n = 100000; n <= 10000000; n *= 10) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"", randomReal(0, 10)});
+        }
+        /* Enqueue-heavy: every element goes in, but only one in ten comes out. */
+        PQHeap binary;
+        PairingHeap<DataPoint> pairing;
+        TIME_OPERATION(n, enqueueEach(binary, input, 10));
+        TIME_OPERATION(n, enqueueEach(pairing, input, 10));
+        EXPECT_EQUAL(pairing.size(), binary.size());
+    }
+
+    for (int numShards = 16; numShards <= 256; numShards *= 4) {
+        Vector<Vector<double>> shards(numShards);
+        for (Vector<double>& shard : shards) {
+            for (int i = 0; i < 1000000 / numShards; i++) {
+                shard.add(randomReal(0, 10));
+            }
+        }
+        auto binaryShards = buildShards<PQHeap>(shards);
+        auto pairingShards = buildShards<PairingHeap<DataPoint>>(shards);
+        int binarySize, pairingSize;
+        TIME_OPERATION(numShards, binarySize = combineShards(binaryShards));
+        TIME_OPERATION(numShards, pairingSize = combineShards(pairingShards));
+        EXPECT_EQUAL(pairingSize, binarySize);
+    }
+}
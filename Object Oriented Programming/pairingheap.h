@@ -0,0 +1,363 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include "strlib.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * Meldable priority queue implemented as a pairing heap.
+ *
+ * The queue is a tree where every node is at least as urgent as its children;
+ * children are kept in a singly linked list. enqueue and meld only ever link
+ * two roots, making the less urgent one the first child of the other, so both
+ * run in time O(1). dequeue removes the root and combines its children pairwise
+ * left to right, then folds the pairs right to left, which takes amortized
+ * O(log n) time.
+ *
+ * Nodes come from a pool owned by the heap: they are carved out of chunks
+ * that double in size as the heap grows, and dequeued nodes are kept on a free
+ * list for the next enqueue, so steady-state use allocates nothing. meld hands
+ * the other heap's chunks and free list over as a whole, which is what keeps
+ * it O(1) in spite of the pool.
+ *
+ * The API matches BasicPQHeap, plus meld. T and Compare are as for BasicPQHeap:
+ * compare(a, b) returns true when a should be dequeued before b.
+ */
+template <typename T, typename Compare = LowerPriorityFirst>
+class PairingHeap {
+public:
+    /**
+     * Creates a new, empty priority queue that orders elements using compare.
+     */
+    explicit PairingHeap(Compare compare = Compare());
+
+    /**
+     * Cleans up every node the heap owns, including those taken over by meld.
+     */
+    ~PairingHeap();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time O(1).
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Removes and returns the frontmost element. If the priority queue is
+     * empty, this function calls error().
+     *
+     * This operation runs in amortized time O(log n).
+     */
+    T dequeue();
+
+    /**
+     * Returns, but does not remove, the frontmost element. If the priority
+     * queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     */
+    const T& peek() const;
+
+    /**
+     * Moves every element of other into this queue, leaving other empty but
+     * usable. Elements are not moved or copied: other's tree and node pool are
+     * linked into this heap. The merged heap orders elements with this heap's
+     * comparator. Melding a heap into itself has no effect.
+     *
+     * This operation runs in time O(1).
+     */
+    void meld(PairingHeap& other);
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue and gives back the memory
+     * of its node pool.
+     */
+    void clear();
+
+    /*
+     * Confirms that every node is no more urgent than its parent and that the
+     * tree holds size() nodes. Raises an error if a problem is found. Intended
+     * solely for testing.
+     */
+    void debugConfirmHeapOrder() const;
+
+private:
+    static const int FIRST_CHUNK_SIZE = 16;     // nodes in the first chunk of the pool
+    static const int MAX_CHUNK_SIZE = 4096;     // chunks stop doubling at this many nodes
+
+    struct Node {
+        T element;
+        Node* child;        // first, most recently linked child
+        Node* sibling;      // next child of the same parent, or next free node
+    };
+
+    /* A block of nodes in the pool. Chunks form a singly linked list so a whole pool can be spliced. */
+    struct Chunk {
+        Node* nodes;
+        int capacity;
+        Chunk* next;
+    };
+
+    Node* allocateNode(T&& element); // takes a node from the free list or the current chunk
+    void releaseNode(Node* node); // puts node on the free list
+    Node* link(Node* first, Node* second); // makes the less urgent root the first child of the other
+    Node* combineSiblings(Node* first); // two-pass pairing of a child list into a single tree
+    void releaseChunks(); // deletes every chunk in the pool
+
+    Node* _root;            // most urgent element, or nullptr when empty
+    int _size;              // number of elements in the tree
+    Chunk* _chunks;         // newest chunk first; nodes are carved from its unused tail
+    Chunk* _lastChunk;      // oldest chunk, so another pool can be appended in O(1)
+    int _chunkUsed;         // nodes of _chunks handed out so far
+    Node* _freeNodes;       // released nodes, linked through sibling
+    Node* _lastFreeNode;    // end of the free list, so another free list can be appended in O(1)
+    Compare _compare;       // compare(a, b) is true when a is more urgent than b
+
+    DISALLOW_COPYING_OF(PairingHeap);
+};
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+template <typename T, typename Compare>
+PairingHeap<T, Compare>::PairingHeap(Compare compare) :
+    _root(nullptr), _size(0), _chunks(nullptr), _lastChunk(nullptr), _chunkUsed(0),
+    _freeNodes(nullptr), _lastFreeNode(nullptr), _compare(std::move(compare)) {
+}
+
+template <typename T, typename Compare>
+PairingHeap<T, Compare>::~PairingHeap() {
+    releaseChunks();
+}
+
+template <typename T, typename Compare>
+void PairingHeap<T, Compare>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+template <typename T, typename Compare>
+void PairingHeap<T, Compare>::enqueue(T&& element) {
+    _root = link(_root, allocateNode(std::move(element)));
+    _size++;
+}
+
+/*
+ * The root's element is moved out and its node goes back to the pool; its children are then
+ * paired up into the new root.
+ */
+template <typename T, typename Compare>
+T PairingHeap<T, Compare>::dequeue() {
+    if (isEmpty()) {
+        error("Cannot dequeue because PairingHeap is empty!");
+    }
+    Node* oldRoot = _root;
+    T result = std::move(oldRoot->element);
+    _root = combineSiblings(oldRoot->child);
+    releaseNode(oldRoot);
+    _size--;
+    return result;
+}
+
+template <typename T, typename Compare>
+const T& PairingHeap<T, Compare>::peek() const {
+    if (isEmpty()) {
+        error("Cannot peek because PairingHeap is empty!");
+    }
+    return _root->element;
+}
+
+/*
+ * Other's chunks go behind ours, so our partly used chunk stays at the front and keeps handing out
+ * nodes; the unused tail of other's newest chunk is simply never used. Other's free list is appended
+ * to ours the same way.
+ */
+template <typename T, typename Compare>
+void PairingHeap<T, Compare>::meld(PairingHeap& other) {
+    if (&other == this) {
+        return;
+    }
+    _root = link(_root, other._root);
+    _size += other._size;
+
+    if (other._chunks != nullptr) {
+        if (_chunks == nullptr) {
+            _chunks = other._chunks;
+            _chunkUsed = other._chunkUsed;
+        } else {
+            _lastChunk->next = other._chunks;
+        }
+        _lastChunk = other._lastChunk;
+    }
+    if (other._freeNodes != nullptr) {
+        if (_freeNodes == nullptr) {
+            _freeNodes = other._freeNodes;
+        } else {
+            _lastFreeNode->sibling = other._freeNodes;
+        }
+        _lastFreeNode = other._lastFreeNode;
+    }
+
+    other._root = nullptr;
+    other._size = 0;
+    other._chunks = other._lastChunk = nullptr;
+    other._chunkUsed = 0;
+    other._freeNodes = other._lastFreeNode = nullptr;
+}
+
+template <typename T, typename Compare>
+bool PairingHeap<T, Compare>::isEmpty() const {
+    return _size == 0;
+}
+
+template <typename T, typename Compare>
+int PairingHeap<T, Compare>::size() const {
+    return _size;
+}
+
+template <typename T, typename Compare>
+void PairingHeap<T, Compare>::clear() {
+    releaseChunks();
+    _root = nullptr;
+    _size = 0;
+    _chunks = _lastChunk = nullptr;
+    _chunkUsed = 0;
+    _freeNodes = _lastFreeNode = nullptr;
+}
+
+template <typename T, typename Compare>
+void PairingHeap<T, Compare>::debugConfirmHeapOrder() const {
+    int count = 0;
+    std::vector<const Node*> pending;
+    if (_root != nullptr) {
+        if (_root->sibling != nullptr) {
+            error("PairingHeap root has a sibling");
+        }
+        pending.push_back(_root);
+    }
+    while (!pending.empty()) {
+        const Node* parent = pending.back();
+        pending.pop_back();
+        count++;
+        for (const Node* child = parent->child; child != nullptr; child = child->sibling) {
+            if (_compare(child->element, parent->element)) {
+                error("PairingHeap has a child more urgent than its parent");
+            }
+            pending.push_back(child);
+        }
+    }
+    if (count != _size) {
+        error("PairingHeap tree holds " + integerToString(count) + " nodes but size is " + integerToString(_size));
+    }
+}
+
+/*
+ * Chunks double from FIRST_CHUNK_SIZE up to MAX_CHUNK_SIZE nodes, so small heaps stay small and
+ * large ones need only one allocation per few thousand enqueues.
+ */
+template <typename T, typename Compare>
+typename PairingHeap<T, Compare>::Node* PairingHeap<T, Compare>::allocateNode(T&& element) {
+    Node* node;
+    if (_freeNodes != nullptr) {
+        node = _freeNodes;
+        _freeNodes = node->sibling;
+        if (_freeNodes == nullptr) {
+            _lastFreeNode = nullptr;
+        }
+    } else {
+        if (_chunks == nullptr || _chunkUsed == _chunks->capacity) {
+            int capacity = _chunks == nullptr ? FIRST_CHUNK_SIZE : std::min(2 * _chunks->capacity, MAX_CHUNK_SIZE);
+            _chunks = new Chunk{ new Node[capacity], capacity, _chunks };
+            if (_lastChunk == nullptr) {
+                _lastChunk = _chunks;
+            }
+            _chunkUsed = 0;
+        }
+        node = &_chunks->nodes[_chunkUsed++];
+    }
+    node->element = std::move(element);
+    node->child = nullptr;
+    node->sibling = nullptr;
+    return node;
+}
+
+template <typename T, typename Compare>
+void PairingHeap<T, Compare>::releaseNode(Node* node) {
+    node->child = nullptr;
+    node->sibling = _freeNodes;
+    if (_freeNodes == nullptr) {
+        _lastFreeNode = node;
+    }
+    _freeNodes = node;
+}
+
+template <typename T, typename Compare>
+typename PairingHeap<T, Compare>::Node* PairingHeap<T, Compare>::link(Node* first, Node* second) {
+    if (first == nullptr) {
+        return second;
+    }
+    if (second == nullptr) {
+        return first;
+    }
+    if (_compare(second->element, first->element)) {
+        std::swap(first, second);
+    }
+    second->sibling = first->child;
+    first->child = second;
+    return first;
+}
+
+/*
+ * First pass: link the children in pairs from left to right, pushing each pair's winner onto a stack
+ * threaded through the sibling pointers. Second pass: pop the stack, which visits the pairs right to
+ * left, linking each into the running result. Both passes are loops, so a root with a very long child
+ * list (e.g. after n enqueues) cannot overflow the call stack.
+ */
+template <typename T, typename Compare>
+typename PairingHeap<T, Compare>::Node* PairingHeap<T, Compare>::combineSiblings(Node* first) {
+    Node* pairs = nullptr;
+    while (first != nullptr) {
+        Node* a = first;
+        Node* b = a->sibling;
+        first = b == nullptr ? nullptr : b->sibling;
+        a->sibling = nullptr;
+        if (b != nullptr) {
+            b->sibling = nullptr;
+        }
+        Node* winner = link(a, b);
+        winner->sibling = pairs;
+        pairs = winner;
+    }
+
+    Node* result = nullptr;
+    while (pairs != nullptr) {
+        Node* next = pairs->sibling;
+        pairs->sibling = nullptr;
+        result = link(pairs, result);
+        pairs = next;
+    }
+    return result;
+}
+
+template <typename T, typename Compare>
+void PairingHeap<T, Compare>::releaseChunks() {
+    while (_chunks != nullptr) {
+        Chunk* next = _chunks->next;
+        delete[] _chunks->nodes;
+        delete _chunks;
+        _chunks = next;
+    }
+}
@@ -4,12 +4,34 @@
  */
 #include "pqarray.h"
 #include "error.h"
+#include "pqheap.h"
 #include "random.h"
 #include "strlib.h"
+#include "testsupport.h"
 #include "SimpleTest.h"
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <memory>
+#include <vector>
 using namespace std;
 
 const int INITIAL_CAPACITY = 10;    // program-wide constant
+const double DEFAULT_GROWTH_FACTOR = 2.0;
+
+/* Past this many elements the array is rearranged into a heap, and at this many or fewer it is sorted
+ * again. Filling and draining a PQArray kept sorted throughout took about as long as one kept as a heap
+ * at 48 to 56 elements, and longer from 64 on. The gap between the two constants keeps a queue that
+ * hovers around the crossover from switching back and forth. */
+const int HEAP_CROSSOVER = 48;
+const int SORTED_CROSSOVER = HEAP_CROSSOVER / 2;
+
+// true if lhs is dequeued after rhs; decreasing priority order, and the order std::make_heap and
+// std::sort_heap are given so that the most urgent element sits at the top of the heap. A lambda rather
+// than a function so that the algorithms it is passed to can inline it.
+const auto dequeuedAfter = [](const DataPoint& lhs, const DataPoint& rhs) {
+    return lhs.priority > rhs.priority;
+};
 
 /*
  * The constructor initializes all of the member variables needed for
@@ -19,57 +41,211 @@ const int INITIAL_CAPACITY = 10;    // program-wide constant
  */
 PQArray::PQArray() {
     _numAllocated = INITIAL_CAPACITY;
-    _elements = new DataPoint[_numAllocated](); // new with parens will zero new memory
+    _elements = allocateSlots(_numAllocated);
     _numFilled = 0;
+    _growthFactor = DEFAULT_GROWTH_FACTOR;
+    _heapOrdered = false;
 }
 
 /* The destructor is responsible for cleaning up any resources
- * used by this instance of the PQArray class. The array
- * memory that was allocated for the PQArray is deleted here.
+ * used by this instance of the PQArray class. The elements are
+ * destroyed and the array memory that was allocated for the
+ * PQArray is freed here.
  */
 PQArray::~PQArray() {
-    delete[] _elements;
+    releaseSlots();
 }
 
-// this method returns void and takes no params, it doubles the number of allocated spots in the
-// array and transfers all datapoints from the current elements arr to a new arr setting it equal to
-// _elements after deleting the old array.
-void PQArray::expandAllocation(){
+// this helper gets raw storage for capacity datapoints; none of them is constructed until it is filled.
+DataPoint* PQArray::allocateSlots(int capacity){
+    return allocator<DataPoint>().allocate(size_t(capacity));
+}
+
+// this helper destroys the filled slots and frees the storage.
+void PQArray::releaseSlots(){
+    destroy(_elements, _elements + _numFilled);
+    allocator<DataPoint>().deallocate(_elements, size_t(_numAllocated));
+}
 
-    _numAllocated = _numAllocated * 2;
+// this method returns void and takes no params, it grows the number of allocated spots in the
+// array by the growth factor.
+void PQArray::expandAllocation(){
+    reallocate(grownCapacity(size() + 1));
+}
 
-    DataPoint *newArray = new DataPoint[_numAllocated];
-    for (int i = 0; i < size(); i++){
-        newArray[i] = _elements[i];
+// this helper multiplies the capacity by the growth factor until needed elements fit, always growing by at
+// least one slot so that factors close to 1 still make progress.
+int PQArray::grownCapacity(int needed) const {
+    int capacity = _numAllocated;
+    while (capacity < needed){
+        double grown = capacity * _growthFactor;
+        capacity = grown < capacity + 1 ? capacity + 1 : (grown > INT_MAX ? INT_MAX : int(grown));
     }
+    return capacity;
+}
+
+// this helper moves all datapoints from the current elements arr into unconstructed storage of the given
+// capacity and frees the old arr. Each datapoint is moved once; nothing is default-constructed first.
+void PQArray::reallocate(int capacity){
 
-    delete[] _elements;
+    DataPoint *newArray = allocateSlots(capacity);
+    uninitialized_move(_elements, _elements + _numFilled, newArray);
+
+    releaseSlots();
 
     _elements = newArray;
+    _numAllocated = capacity;
 }
 
 /*
- * This method enquur, takes a datapoint and inputs it into the current elements queue
- * respecting priority values in the queue sorted from largest to smallest going left to right
- * This is accomplished by adding the current elem Datapoint to the beginning (right) of the queue
- * then continually swapping it with the Datapoint to its left if it has a larger priority value.
+ * This method enqueue, takes a datapoint and inputs it into the current elements queue
+ * respecting priority values in the queue sorted from largest to smallest going left to right.
+ * The slot is found with a binary search for the first datapoint of smaller priority, so elem lands
+ * to the right of any equal ones and is dequeued before them. The last datapoint is moved into the
+ * unconstructed slot at the end and the rest of the tail is moved over by one with move_backward,
+ * which moves each string's buffer instead of copying it. (A raw memmove is not an option: a short
+ * std::string may point into itself.) Once the queue is past HEAP_CROSSOVER the array is a heap and
+ * elem is percolated up from a new slot at the end, as in PQHeap: the unconstructed end slot is
+ * move-constructed from elem, or from the parent elem displaces, rather than built empty first.
  */
 void PQArray::enqueue(DataPoint elem) {
-    /* TODO: Implement this function. */
-
     if (size() == _numAllocated){
         expandAllocation();
     }
+    if (!_heapOrdered && size() >= HEAP_CROSSOVER){
+        makeHeapOrdered();
+    }
 
-    _elements[size()] = elem;
+    DataPoint* end = _elements + size();
+    if (_heapOrdered){
+        int parent = (size() - 1) / 2;
+        if (size() == 0 || !(elem.priority < _elements[parent].priority)){
+            ::new (static_cast<void*>(end)) DataPoint(std::move(elem));
+            _numFilled ++;
+            return;
+        }
+        ::new (static_cast<void*>(end)) DataPoint(std::move(_elements[parent]));
+        _numFilled ++;
+        percolateUp(parent, std::move(elem));
+        return;
+    }
+
+    DataPoint* slot = upper_bound(_elements, end, elem.priority, [](double priority, const DataPoint& pt) {
+        return priority > pt.priority;
+    });
+    if (slot == end){
+        ::new (static_cast<void*>(end)) DataPoint(std::move(elem));
+    } else {
+        ::new (static_cast<void*>(end)) DataPoint(std::move(end[-1]));
+        move_backward(slot, end - 1, end);
+        *slot = std::move(elem);
+    }
     _numFilled ++;
+}
+
+// this helper turns the sorted array into a heap in place, in time O(n).
+void PQArray::makeHeapOrdered(){
+    make_heap(_elements, _elements + size(), dequeuedAfter);
+    _heapOrdered = true;
+}
+
+// this helper sorts the heap back into decreasing priority order, in time O(n log n).
+void PQArray::makeSorted(){
+    sort_heap(_elements, _elements + size(), dequeuedAfter);
+    _heapOrdered = false;
+}
+
+// this helper moves the heap's hole up while its parent is less urgent than elem, then puts elem there.
+// (std::push_heap and std::pop_heap would do, but pop_heap sinks its hole all the way to a leaf before
+// sifting back up, which costs more moves of the strings than stopping where elem belongs.)
+void PQArray::percolateUp(int hole, DataPoint&& elem){
+    while (hole > 0){
+        int parent = (hole - 1) / 2;
+        if (!(elem.priority < _elements[parent].priority)){
+            break;
+        }
+        _elements[hole] = std::move(_elements[parent]);
+        hole = parent;
+    }
+    _elements[hole] = std::move(elem);
+}
+
+// this helper moves the heap's hole down while its more urgent child is more urgent than elem, then puts
+// elem there.
+void PQArray::percolateDown(int hole, DataPoint&& elem){
+    while (true){
+        int child = 2 * hole + 1;
+        if (child >= size()){
+            break;
+        }
+        if (child + 1 < size() && _elements[child + 1].priority < _elements[child].priority){
+            child ++;
+        }
+        if (!(_elements[child].priority < elem.priority)){
+            break;
+        }
+        _elements[hole] = std::move(_elements[child]);
+        hole = child;
+    }
+    _elements[hole] = std::move(elem);
+}
 
-    int i = size() - 1;
-    while (i > 0 && (elem.priority > _elements[i - 1].priority)){
-        DataPoint previous = _elements[i - 1];
-        _elements[i - 1] = elem;
-        _elements[i] = previous;
-        i --;
+// this method, makeRoomFor, makes sure count more elements fit in the array. It grows the allocation
+// as many times as needed but moves the elements only once.
+void PQArray::makeRoomFor(int count){
+    int needed = size() + count;
+    if (needed > _numAllocated){
+        reallocate(grownCapacity(needed));
+    }
+}
+
+/*
+ * This method, mergeBatch, orders the unsorted elements from batchStart to the end of the array. They
+ * are moved aside and sorted, and then merged with the sorted part from the back: at each step the
+ * lower-priority value of the two sorted parts is written into the last open slot, so each old element
+ * moves at most once. On equal priorities the batch element is placed to be dequeued first, as enqueue
+ * would place it.
+ *
+ * If the array is already a heap, a small batch is pushed onto it one element at a time and a large one
+ * is heapified together with the rest, as PQHeap::enqueueAll does. If the batch takes a sorted array
+ * past HEAP_CROSSOVER, there is no point sorting it: the whole array is heapified instead.
+ */
+void PQArray::mergeBatch(int batchStart){
+    if (_heapOrdered && size() - batchStart < batchStart){
+        for (int i = batchStart; i < size(); i++){
+            DataPoint elem = std::move(_elements[i]);
+            percolateUp(i, std::move(elem));
+        }
+        return;
+    }
+    if (_heapOrdered || size() > HEAP_CROSSOVER){
+        makeHeapOrdered();
+        return;
+    }
+
+    vector<DataPoint> batch(make_move_iterator(_elements + batchStart), make_move_iterator(_elements + size()));
+    sort(batch.begin(), batch.end(), dequeuedAfter);
+
+    int out = size() - 1;
+    int old = batchStart - 1;
+    int next = int(batch.size()) - 1;
+    while (next >= 0){
+        if (old >= 0 && _elements[old].priority < batch[next].priority){
+            _elements[out] = std::move(_elements[old]);
+            old --;
+        } else {
+            _elements[out] = std::move(batch[next]);
+            next --;
+        }
+        out --;
+    }
+}
+
+// this method, checkDequeueCount, raises an error if n elements cannot be dequeued at once.
+void PQArray::checkDequeueCount(int n) const {
+    if (n < 0 || n > size()){
+        error("Cannot dequeueMany " + integerToString(n) + " elements from PQArray of size "
+              + integerToString(size()) + "!");
     }
 }
 
@@ -86,24 +262,45 @@ int PQArray::size() const {
  * of priority value. The element at index 0 is the least urgent
  * (largest priority value) and the element in the last-filled index
  * is the most urgent (minimum priority value). peek() returns the
- * frontmost elements, which is stored at the last-filled index.
+ * frontmost elements, which is stored at the last-filled index, or
+ * at index 0 once the array is a heap.
  * peek() raises an error if the queue is empty.
  */
 DataPoint PQArray::peek() const {
     if (isEmpty()) {
         error("Cannot access front element of empty pqueue!");
     }
-    return _elements[size() - 1];
+    return _heapOrdered ? _elements[0] : _elements[size() - 1];
 }
 
 /*
  * This function returns the value of the frontmost element and removes
  * it from the queue.  Because the frontmost element was at the
- * last-filled index, decrementing count is sufficient to remove it.
+ * last-filled index, it is moved out and its slot destroyed. A heap
+ * gives up its top instead, and the element from the last-filled index
+ * is percolated down from there. The heap is sorted again once it is
+ * down to SORTED_CROSSOVER elements.
  */
 DataPoint PQArray::dequeue() {
-    DataPoint front = peek();
+    if (isEmpty()) {
+        error("Cannot access front element of empty pqueue!");
+    }
+    if (!_heapOrdered) {
+        _numFilled--;
+        DataPoint front = std::move(_elements[_numFilled]);
+        destroy_at(_elements + _numFilled);
+        return front;
+    }
+    DataPoint front = std::move(_elements[0]);
     _numFilled--;
+    DataPoint last = std::move(_elements[_numFilled]);
+    destroy_at(_elements + _numFilled);
+    if (!isEmpty()) {
+        percolateDown(0, std::move(last));
+    }
+    if (size() <= SORTED_CROSSOVER) {
+        makeSorted();
+    }
     return front;
 }
 
@@ -115,14 +312,53 @@ bool PQArray::isEmpty() const {
 }
 
 /*
- * Updates internal state to reflect that the queue is empty, i.e. count
- * of filled slots is reset to zero. The array memory remains allocated
- * at current capacity. The contents of the internal array do not need to
- * be cleared; the contents will be overwritten when additional values
- * are enqueued.
+ * Updates internal state to reflect that the queue is empty, i.e. the
+ * elements are destroyed and the count of filled slots is reset to zero.
+ * The array memory remains allocated at current capacity.
  */
 void PQArray::clear() {
+    destroy(_elements, _elements + _numFilled);
     _numFilled = 0;
+    _heapOrdered = false;
+}
+
+/*
+ * Returns the number of allocated slots in the array.
+ */
+int PQArray::capacity() const {
+    return _numAllocated;
+}
+
+/*
+ * Reallocates straight to the requested capacity if it is more than what is
+ * allocated now; the growth factor plays no part.
+ */
+void PQArray::reserve(int capacity) {
+    if (capacity < 0) {
+        error("Cannot reserve a negative capacity " + integerToString(capacity) + " for PQArray!");
+    }
+    if (capacity > _numAllocated) {
+        reallocate(capacity);
+    }
+}
+
+/*
+ * Reallocates the array to exactly the filled size.
+ */
+void PQArray::shrinkToFit() {
+    if (size() < _numAllocated) {
+        reallocate(size());
+    }
+}
+
+/*
+ * Changes the factor expandAllocation grows by from now on.
+ */
+void PQArray::setGrowthFactor(double factor) {
+    if (!(factor > 1)) {
+        error("PQArray growth factor must be greater than 1, not " + realToString(factor) + "!");
+    }
+    _growthFactor = factor;
 }
 
 /*
@@ -153,7 +389,8 @@ void PQArray::validateIndex(int index) const {
  * Confirm the state of the internal array is valid for this queue.
  * For PQArray, elements in the array must be stored in decreasing
  * order of priority.  If a pair of elements is found to be out
- * of order, report an error.
+ * of order, report an error. Once the array is a heap, each element
+ * must instead be no more urgent than its parent.
  */
 void PQArray::debugConfirmInternalArray() const {
     /*
@@ -161,6 +398,16 @@ void PQArray::debugConfirmInternalArray() const {
      */
     if (_numFilled > _numAllocated) error("Too many elements in not enough space!");
 
+    if (_heapOrdered) {
+        for (int i = 1; i < size(); i++) {
+            int parent = (i - 1) / 2;
+            if (_elements[i].priority < _elements[parent].priority) {
+                error("PQArray heap out of order: indexes " + integerToString(parent) + " and " + integerToString(i));
+            }
+        }
+        return;
+    }
+
     /* Loop over internal array and compare priority of neighboring elements.
      * If element at index i has larger priority than at index i-1,
      * these two elements are out of order expected for PQArray.
@@ -198,12 +445,13 @@ void PQArray::debugSetInternalArrayContents(const Vector<DataPoint>& v, int capa
     if (v.size() > capacity || capacity == 0) {
         error("Invalid capacity for debugSetInternalArrayContents!");
     }
-    delete[] _elements;                     // discard old memory
-    _elements = new DataPoint[capacity];    // allocate new memory
+    releaseSlots();                         // discard old memory
+    _elements = allocateSlots(capacity);    // allocate new memory
     _numAllocated = capacity;
     _numFilled = v.size();
+    _heapOrdered = false;
     for (int i = 0; i < v.size(); i++) {    // fill contents with copy from vector
-        _elements[i] = v[i];
+        ::new (static_cast<void*>(_elements + i)) DataPoint(v[i]);
     }
     debugConfirmInternalArray();            // confirm contents valid
 }
@@ -232,6 +480,170 @@ STUDENT_TEST("testing expandAllocation"){
     EXPECT_EQUAL(pq.size() * 2, 320);
 }
 
+STUDENT_TEST("PQArray: enqueueAll merges a batch into the sorted array, dequeueMany drains it in order") {
+    PQArray pq;
+    pq.enqueue({"b", 2});
+    pq.enqueue({"e", 5});
+
+    Vector<DataPoint> batch = { {"d", 4}, {"a", 1}, {"f", 6}, {"c", 3} };
+    pq.enqueueAll(batch);
+    EXPECT_EQUAL(batch.size(), 4);                          // an lvalue range is copied from
+    EXPECT_EQUAL(pq.size(), 6);
+    pq.debugConfirmInternalArray();
+
+    DataPoint out[4];
+    EXPECT(pq.dequeueMany(4, out) == out + 4);
+    EXPECT_EQUAL(out[0], {"a", 1});
+    EXPECT_EQUAL(out[3], {"d", 4});
+    EXPECT_ERROR(pq.dequeueMany(3, out));
+    EXPECT_ERROR(pq.dequeueMany(-1, out));
+    EXPECT(pq.dequeueMany(0, out) == out);
+
+    vector<DataPoint> rest;
+    pq.dequeueMany(2, back_inserter(rest));
+    EXPECT_EQUAL(rest, { {"e", 5}, {"f", 6} });
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("PQArray: enqueueAll matches one enqueue per element on random batches") {
+    setRandomSeed(17);
+    PQArray batched, single;
+    for (int round = 0; round < 20; round++) {
+        Vector<DataPoint> batch;
+        for (int i = randomInteger(0, 60); i > 0; i--) {
+            batch.add({"", double(randomInteger(0, 30))});
+        }
+        for (const DataPoint& pt : batch) {
+            single.enqueue(pt);
+        }
+        batched.enqueueAll(std::move(batch));
+        batched.debugConfirmInternalArray();
+        EXPECT_EQUAL(batched.size(), single.size());
+
+        int n = randomInteger(0, batched.size() / 2);
+        Vector<DataPoint> taken(n);
+        if (n > 0) {
+            batched.dequeueMany(n, &taken[0]);
+        }
+        for (int i = 0; i < n; i++) {
+            EXPECT_EQUAL(taken[i].priority, single.dequeue().priority);
+        }
+    }
+}
+
+STUDENT_TEST("PQArray: reserve, shrinkToFit and growth factor control the capacity") {
+    PQArray pq;
+    EXPECT_EQUAL(pq.capacity(), 10);
+    pq.reserve(100);
+    EXPECT_EQUAL(pq.capacity(), 100);
+    pq.reserve(5);
+    EXPECT_EQUAL(pq.capacity(), 100);
+    EXPECT_ERROR(pq.reserve(-1));
+
+    for (int i = 0; i < 101; i++) {
+        pq.enqueue({"", double(i)});
+    }
+    EXPECT_EQUAL(pq.capacity(), 200);
+    for (int i = 0; i < 90; i++) {
+        EXPECT_EQUAL(pq.dequeue().priority, i);
+    }
+    pq.shrinkToFit();
+    EXPECT_EQUAL(pq.capacity(), 11);
+    pq.debugConfirmInternalArray();
+    EXPECT_EQUAL(pq.peek().priority, 90);
+
+    pq.clear();
+    pq.shrinkToFit();
+    EXPECT_EQUAL(pq.capacity(), 0);
+    pq.setGrowthFactor(1.5);
+    for (int i = 0; i < 3; i++) {
+        pq.enqueue({"", double(i)});                            // 0 -> 1 -> 2 -> 3
+    }
+    EXPECT_EQUAL(pq.capacity(), 3);
+    pq.enqueue({"", 3});
+    EXPECT_EQUAL(pq.capacity(), 4);
+    EXPECT_ERROR(pq.setGrowthFactor(0.5));
+}
+
+STUDENT_TEST("PQArray: equal priorities still leave the newest element frontmost") {
+    PQArray pq;
+    pq.enqueue({"older", 2});
+    pq.enqueue({"low", 3});
+    pq.enqueue({"newer", 2});
+    pq.enqueue({"high", 1});
+    EXPECT_EQUAL(pq.debugGetInternalArrayContents(), { {"low", 3}, {"older", 2}, {"newer", 2}, {"high", 1} });
+    EXPECT_EQUAL(pq.dequeue(), {"high", 1});
+    EXPECT_EQUAL(pq.dequeue(), {"newer", 2});
+}
+
+STUDENT_TEST("PQArray: becomes a heap past the crossover and sorted again once drained") {
+    setRandomSeed(21);
+    PQArray pq;
+    PQHeap reference;
+    for (int i = 0; i < 200; i++) {
+        DataPoint elem = {"a label long enough to need its own buffer", double(randomInteger(0, 50))};
+        pq.enqueue(elem);
+        reference.enqueue(elem);
+        pq.debugConfirmInternalArray();
+        EXPECT_EQUAL(pq.peek().priority, reference.peek().priority);
+    }
+    Vector<DataPoint> contents = pq.debugGetInternalArrayContents();
+    EXPECT_EQUAL(contents[0].priority, reference.peek().priority);      // heap: front at index 0
+
+    int capacity = pq.capacity();
+    while (pq.size() > 10) {
+        EXPECT_EQUAL(pq.dequeue().priority, reference.dequeue().priority);
+        pq.debugConfirmInternalArray();
+    }
+    EXPECT_EQUAL(pq.capacity(), capacity);                              // same storage throughout
+    contents = pq.debugGetInternalArrayContents();
+    EXPECT_EQUAL(contents[9].priority, reference.peek().priority);      // sorted: front at the end
+
+    Vector<DataPoint> batch;
+    for (int i = 0; i < 100; i++) {
+        batch.add({"", double(randomInteger(0, 50))});
+        reference.enqueue(batch[i]);
+    }
+    pq.enqueueAll(batch);
+    pq.debugConfirmInternalArray();
+    pq.enqueueAll(Vector<DataPoint>{ {"", -1}, {"", 100} });
+    reference.enqueueAll(Vector<DataPoint>{ {"", -1}, {"", 100} });
+    pq.debugConfirmInternalArray();
+    vector<DataPoint> drained;
+    pq.dequeueMany(pq.size(), back_inserter(drained));
+    for (const DataPoint& pt : drained) {
+        EXPECT_EQUAL(pt.priority, reference.dequeue().priority);
+    }
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("PQArray: time against PQHeap at sizes around the crossover") {
+    for (int n = 12; n <= 3072; n *= 4) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"", randomReal(0, 10)});
+        }
+        int rounds = 1000000 / n;
+        PQArray array;
+        PQHeap heap;
+        TIME_OPERATION(n, fillThenDrain(array, input, rounds));
+        TIME_OPERATION(n, fillThenDrain(heap, input, rounds));
+    }
+}
+
+STUDENT_TEST("PQArray: time enqueueAll against one enqueue per element") {
+    for (int n = 10000; n <= 40000; n *= 2) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"", randomReal(0, 10)});
+        }
+        PQArray single, batched;
+        TIME_OPERATION(n, enqueueEach(single, input));
+        TIME_OPERATION(n, batched.enqueueAll(input));
+        EXPECT_EQUAL(batched.size(), n);
+    }
+}
+
 
 /* * * * * Provided Tests Below This Point * * * * */
 
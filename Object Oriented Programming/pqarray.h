@@ -2,9 +2,24 @@
 #include "MemoryUtils.h"
 #include "datapoint.h"
 #include "vector.h"
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 /**
  * Priority queue of DataPoints implemented using a sorted array.
+ *
+ * Slots past the last element are left unconstructed, so growing the array
+ * moves each element once into fresh storage. reserve, shrinkToFit and
+ * setGrowthFactor give callers control over how much memory the queue holds.
+ *
+ * A sorted array only beats a heap while it is small, so once the queue grows
+ * past a crossover size (measured at about 48 elements) the same array is
+ * rearranged into a binary min-heap and enqueue and dequeue both run in
+ * O(log n) from then on. When the queue has drained to half that size the
+ * array is sorted again. The two layouts share one allocation, so the switch
+ * does not change the capacity.
  */
 class PQArray {
 public:
@@ -19,13 +34,29 @@ public:
     ~PQArray();
 
     /**
-     * Adds a new element into the queue. This operation runs in time O(N),
-     * where n is the number of elements in the queue.
+     * Adds a new element into the queue. While the array is sorted, the slot
+     * is found by binary search and the elements after it are shifted over by
+     * one in a single block move, so this runs in time O(n) but with a small
+     * constant; once the array is a heap it runs in time O(log n).
      *
      * @param element The element to add.
      */
     void enqueue(DataPoint element);
 
+    /**
+     * Adds every element of range (anything with begin() and end(), such as a
+     * Vector) to the queue. The array grows at most once, and instead of
+     * shifting each element into place the batch is sorted and merged into the
+     * array from the back, so this runs in time O(n + count log count) rather
+     * than O(count * n). A batch that takes the queue past the crossover size
+     * is heapified along with the rest of the array in time O(n + count).
+     * Elements are moved out of range if it is an rvalue and copied otherwise.
+     *
+     * @param range The elements to add.
+     */
+    template <typename Range>
+    void enqueueAll(Range&& range);
+
     /**
      * Removes and returns the element that is frontmost in this priority queue.
      * The frontmost element is the one with the most urgent priority. A priority
@@ -36,12 +67,25 @@ public:
      *
      * If the priority queue is empty, this function calls error().
      *
-     * This operation runs in time O(1).
+     * This operation runs in time O(1) while the array is sorted and O(log n)
+     * once it is a heap.
      *
      * @return The frontmost element, which is removed from queue.
      */
     DataPoint dequeue();
 
+    /**
+     * Removes the n frontmost elements and writes them, frontmost first, to
+     * out, which can be a pointer into the caller's buffer or any other output
+     * iterator. Returns out advanced past the last element written. If n is
+     * negative or more than size(), this function calls error().
+     *
+     * This operation runs in time O(n) while the array is sorted and
+     * O(n log size()) while it is a heap.
+     */
+    template <typename OutputIt>
+    OutputIt dequeueMany(int n, OutputIt out);
+
     /**
      * Returns, but does not remove, the element that is frontmost.
      *
@@ -72,12 +116,36 @@ public:
     int size() const;
 
     /**
-     * Removes all elements from the priority queue.
-     *
-     * This operation runs in time O(1).
+     * Removes all elements from the priority queue. The elements are destroyed,
+     * which takes time O(n), but the allocated capacity is kept for reuse; call
+     * shrinkToFit afterwards to release it.
      */
     void clear();
 
+    /**
+     * Returns the number of elements the queue can hold before it has to grow.
+     */
+    int capacity() const;
+
+    /**
+     * Makes sure the queue can hold at least capacity elements without growing
+     * again. Never shrinks the queue. If capacity is negative, this function
+     * calls error().
+     */
+    void reserve(int capacity);
+
+    /**
+     * Releases any allocated capacity beyond size().
+     */
+    void shrinkToFit();
+
+    /**
+     * Sets the factor by which the capacity is multiplied each time the queue
+     * runs out of room (2 by default). If factor is not greater than 1, this
+     * function calls error().
+     */
+    void setGrowthFactor(double factor);
+
 
     /*
      * These three "debug" functions are intended solely for testing.
@@ -91,6 +159,9 @@ public:
      * internal array as part of a hand-constructed test case.
      * Such debug functions would typically be used early in development
      * and could be removed (or made private) once past the need for them.
+     * Past the crossover size the internal array is a heap rather than sorted;
+     * debugConfirmInternalArray checks whichever layout is in use, and
+     * debugSetInternalArrayContents always installs a sorted array.
      */
 
     /*
@@ -112,12 +183,31 @@ public:
 
 private:
 
-    //helper function that expands allocation size of array by factor of 2
+    //helper function that expands allocation size of array by the growth factor
     void expandAllocation();
 
-    DataPoint* _elements;   // dynamic array
+    //helper functions that manage the partly constructed array
+    int grownCapacity(int needed) const;        // the capacity to grow to so that needed elements fit
+    void reallocate(int capacity);              // moves the elements into new storage of capacity slots
+    static DataPoint* allocateSlots(int capacity); // raw storage, no element constructed
+    void releaseSlots();                        // destroys the elements and frees the storage
+
+    //helper functions for the batch operations
+    void makeRoomFor(int count);        // grows the array once so count more elements fit
+    void mergeBatch(int batchStart);    // sorts or heapifies the elements from batchStart on into the rest
+    void checkDequeueCount(int n) const; // calls error() unless 0 <= n <= size()
+
+    //helper functions that switch between the sorted and the heap layout
+    void makeHeapOrdered();             // rearranges the sorted array into a heap
+    void makeSorted();                  // sorts the heap back into decreasing order
+    void percolateUp(int hole, DataPoint&& elem);   // heap: moves the hole up past less urgent parents, then fills it
+    void percolateDown(int hole, DataPoint&& elem); // heap: moves the hole down past more urgent children, then fills it
+
+    DataPoint* _elements;   // dynamic array; only the first _numFilled slots hold constructed elements
     int _numAllocated;      // number of slots allocated in array
     int _numFilled;         // number of slots filled in array
+    double _growthFactor;   // expandAllocation multiplies _numAllocated by this
+    bool _heapOrdered;      // true once the array holds a min-heap instead of decreasing priorities
 
     void validateIndex(int index) const;
     void swapElements(int indexA, int indexB);
@@ -131,3 +221,52 @@ private:
      */
     DISALLOW_COPYING_OF(PQArray);
 };
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+/*
+ * The batch operations are templates so they take any range or output iterator, which means they have
+ * to be defined here. The work that does not depend on the template arguments is in pqarray.cpp.
+ */
+
+/*
+ * This method, enqueueAll, appends the whole batch after the current elements without ordering it
+ * and then lets mergeBatch put it in place.
+ */
+template <typename Range>
+void PQArray::enqueueAll(Range&& range) {
+    int batchStart = size();
+    makeRoomFor(int(std::distance(std::begin(range), std::end(range))));
+
+    for (auto&& element : range) {
+        if constexpr (std::is_lvalue_reference<Range>::value) {
+            ::new (static_cast<void*>(_elements + _numFilled)) DataPoint(element);
+        } else {
+            ::new (static_cast<void*>(_elements + _numFilled)) DataPoint(std::move(element));
+        }
+        _numFilled++;
+    }
+    mergeBatch(batchStart);
+}
+
+/*
+ * This method, dequeueMany, hands out the frontmost elements from the end of the array, which is
+ * where they already sit in order. A heap-ordered array is drained through dequeue, which also sorts
+ * it again once it has shrunk enough.
+ */
+template <typename OutputIt>
+OutputIt PQArray::dequeueMany(int n, OutputIt out) {
+    checkDequeueCount(n);
+    for (int i = 0; i < n; i++) {
+        if (_heapOrdered) {
+            *out = dequeue();
+        } else {
+            _numFilled--;
+            *out = std::move(_elements[_numFilled]);
+            std::destroy_at(_elements + _numFilled);
+        }
+        ++out;
+    }
+    return out;
+}
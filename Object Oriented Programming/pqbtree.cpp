@@ -0,0 +1,484 @@
+/*
+ * This file, pqbtree, implements the PQBTree class declared in pqbtree.h, followed by its test cases and
+ * time trials against PQHeap and against binary search over a sorted Vector.
+ */
+#include "pqbtree.h"
+#include "error.h"
+#include "pqheap.h"
+#include "random.h"
+#include "strlib.h"
+#include "testsupport.h"
+#include "SimpleTest.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+using namespace std;
+
+/*
+ * Orders DataPoints by priority alone, for the binary searches within a leaf.
+ */
+static bool lowerPriority(const DataPoint& lhs, const DataPoint& rhs) {
+    return lhs.priority < rhs.priority;
+}
+
+PQBTree::PQBTree() : _root(nullptr), _height(0), _first(nullptr), _size(0) {
+    _first = new Leaf;
+    _root = _first;
+}
+
+PQBTree::~PQBTree() {
+    release(_root, _height);
+}
+
+/*
+ * A root that splits gets a new root above it with the two halves as children, which is the only way the
+ * tree grows taller.
+ */
+void PQBTree::enqueue(DataPoint element) {
+    double splitLowest;
+    void* right = insertInto(_root, _height, std::move(element), splitLowest);
+    if (right != nullptr) {
+        Inner* root = new Inner;
+        root->count = 2;
+        root->lowest[0] = -numeric_limits<double>::infinity();
+        root->lowest[1] = splitLowest;
+        root->sizes[0] = subtreeSize(_root, _height);
+        root->sizes[1] = subtreeSize(right, _height);
+        root->children[0] = _root;
+        root->children[1] = right;
+        _root = root;
+        _height++;
+    }
+    _size++;
+}
+
+/*
+ * Adds element under node, which is level levels above the leaves. If node had to split to make room,
+ * returns the new right half and stores the smallest priority in it in splitLowest; otherwise returns
+ * nullptr.
+ *
+ * A full leaf gives its upper half to a new leaf, except that an element going past the end of the last
+ * leaf starts a new leaf of its own: that way a queue filled in increasing order of priority ends up
+ * with full leaves rather than half-full ones.
+ */
+void* PQBTree::insertInto(void* node, int level, DataPoint&& element, double& splitLowest) {
+    if (level == 0) {
+        Leaf* leaf = static_cast<Leaf*>(node);
+        int slot = int(upper_bound(leaf->elements, leaf->elements + leaf->count, element, lowerPriority) - leaf->elements);
+        Leaf* target = leaf;
+        Leaf* right = nullptr;
+        if (leaf->count == LEAF_CAPACITY) {
+            right = new Leaf;
+            int keep = (slot == LEAF_CAPACITY && leaf->next == nullptr) ? LEAF_CAPACITY : LEAF_CAPACITY / 2;
+            move(leaf->elements + keep, leaf->elements + LEAF_CAPACITY, right->elements);
+            right->count = LEAF_CAPACITY - keep;
+            leaf->count = keep;
+            right->next = leaf->next;
+            leaf->next = right;
+            if (slot > keep || keep == LEAF_CAPACITY) {
+                target = right;
+                slot -= keep;
+            }
+        }
+        move_backward(target->elements + slot, target->elements + target->count, target->elements + target->count + 1);
+        target->elements[slot] = std::move(element);
+        target->count++;
+        if (right != nullptr) {
+            splitLowest = right->elements[0].priority;
+        }
+        return right;
+    }
+
+    Inner* inner = static_cast<Inner*>(node);
+    int child = findChild(inner, element.priority, true);
+    inner->sizes[child]++;
+    double childLowest;
+    void* split = insertInto(inner->children[child], level - 1, std::move(element), childLowest);
+    if (split == nullptr) {
+        return nullptr;
+    }
+    inner->sizes[child] = subtreeSize(inner->children[child], level - 1);
+    int splitSize = subtreeSize(split, level - 1);
+
+    Inner* target = inner;
+    Inner* right = nullptr;
+    int pos = child + 1;
+    if (inner->count == INNER_CAPACITY) {
+        right = new Inner;
+        int keep = INNER_CAPACITY / 2;
+        right->count = INNER_CAPACITY - keep;
+        copy(inner->lowest + keep, inner->lowest + INNER_CAPACITY, right->lowest);
+        copy(inner->sizes + keep, inner->sizes + INNER_CAPACITY, right->sizes);
+        copy(inner->children + keep, inner->children + INNER_CAPACITY, right->children);
+        inner->count = keep;
+        if (pos > keep) {
+            target = right;
+            pos -= keep;
+        }
+    }
+    copy_backward(target->lowest + pos, target->lowest + target->count, target->lowest + target->count + 1);
+    copy_backward(target->sizes + pos, target->sizes + target->count, target->sizes + target->count + 1);
+    copy_backward(target->children + pos, target->children + target->count, target->children + target->count + 1);
+    target->lowest[pos] = childLowest;
+    target->sizes[pos] = splitSize;
+    target->children[pos] = split;
+    target->count++;
+    if (right != nullptr) {
+        splitLowest = right->lowest[0];
+    }
+    return right;
+}
+
+/*
+ * Counts the elements under node: a leaf knows its count and an inner node keeps one per child.
+ */
+int PQBTree::subtreeSize(void* node, int level) const {
+    if (level == 0) {
+        return static_cast<Leaf*>(node)->count;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    int total = 0;
+    for (int i = 0; i < inner->count; i++) {
+        total += inner->sizes[i];
+    }
+    return total;
+}
+
+/*
+ * Returns the child of inner to look under for priority. Child i holds nothing below lowest[i], so the
+ * child is the number of lowest[1..] values below priority, or, with pastEqual, not above it: an insert
+ * goes past every element of equal priority, while a search wants the first one.
+ */
+int PQBTree::findChild(const Inner* inner, double priority, bool pastEqual) const {
+    const double* begin = inner->lowest + 1;
+    const double* end = inner->lowest + inner->count;
+    return int((pastEqual ? upper_bound(begin, end, priority) : lower_bound(begin, end, priority)) - begin);
+}
+
+/*
+ * The empty leaf at the front is deleted as soon as it empties, and its parent, if that empties in turn,
+ * and so on; the front is always in _first. The root is never deleted here, and afterwards a root left
+ * with a single child hands over to that child.
+ */
+DataPoint PQBTree::dequeue() {
+    if (isEmpty()) {
+        error("Cannot dequeue because PQBTree is empty!");
+    }
+    DataPoint front;
+    removeFront(_root, _height, front);
+    _size--;
+    if (_height > 0 && static_cast<Inner*>(_root)->count == 0) {
+        delete static_cast<Inner*>(_root);
+        _first = new Leaf;
+        _root = _first;
+        _height = 0;
+    }
+    while (_height > 0 && static_cast<Inner*>(_root)->count == 1) {
+        Inner* root = static_cast<Inner*>(_root);
+        _root = root->children[0];
+        delete root;
+        _height--;
+    }
+    return front;
+}
+
+/*
+ * Moves the leftmost element under node into front and returns whether node is now empty.
+ */
+bool PQBTree::removeFront(void* node, int level, DataPoint& front) {
+    if (level == 0) {
+        Leaf* leaf = static_cast<Leaf*>(node);
+        front = std::move(leaf->elements[0]);
+        move(leaf->elements + 1, leaf->elements + leaf->count, leaf->elements);
+        leaf->count--;
+        return leaf->count == 0;
+    }
+
+    Inner* inner = static_cast<Inner*>(node);
+    inner->sizes[0]--;
+    if (removeFront(inner->children[0], level - 1, front)) {
+        if (level == 1) {
+            Leaf* emptied = static_cast<Leaf*>(inner->children[0]);
+            _first = emptied->next;
+            delete emptied;
+        } else {
+            delete static_cast<Inner*>(inner->children[0]);
+        }
+        copy(inner->lowest + 1, inner->lowest + inner->count, inner->lowest);
+        copy(inner->sizes + 1, inner->sizes + inner->count, inner->sizes);
+        copy(inner->children + 1, inner->children + inner->count, inner->children);
+        inner->count--;
+    }
+    return inner->count == 0;
+}
+
+const DataPoint& PQBTree::peek() const {
+    if (isEmpty()) {
+        error("Cannot peek because PQBTree is empty!");
+    }
+    return _first->elements[0];
+}
+
+/*
+ * Each level skips the children whose element counts add up to no more than what is left of rank.
+ */
+const DataPoint& PQBTree::select(int rank) const {
+    if (rank < 0 || rank >= _size) {
+        error("PQBTree rank " + integerToString(rank) + " is out of range!");
+    }
+    const void* node = _root;
+    for (int level = _height; level > 0; level--) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        int child = 0;
+        while (rank >= inner->sizes[child]) {
+            rank -= inner->sizes[child];
+            child++;
+        }
+        node = inner->children[child];
+    }
+    return static_cast<const Leaf*>(node)->elements[rank];
+}
+
+/*
+ * Every child left of the one searched holds only priorities below the given one, so their counts are
+ * added up without looking inside.
+ */
+int PQBTree::rank(double priority) const {
+    int result = 0;
+    const void* node = _root;
+    for (int level = _height; level > 0; level--) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        int child = findChild(inner, priority, false);
+        for (int i = 0; i < child; i++) {
+            result += inner->sizes[i];
+        }
+        node = inner->children[child];
+    }
+    const Leaf* leaf = static_cast<const Leaf*>(node);
+    DataPoint key = {"", priority};
+    return result + int(lower_bound(leaf->elements, leaf->elements + leaf->count, key, lowerPriority) - leaf->elements);
+}
+
+/*
+ * The slot returned can be one past the leaf's last element, when the first element at or above priority
+ * is at the start of the next leaf.
+ */
+const PQBTree::Leaf* PQBTree::findLeaf(double priority, int& slot) const {
+    const void* node = _root;
+    for (int level = _height; level > 0; level--) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        node = inner->children[findChild(inner, priority, false)];
+    }
+    const Leaf* leaf = static_cast<const Leaf*>(node);
+    DataPoint key = {"", priority};
+    slot = int(lower_bound(leaf->elements, leaf->elements + leaf->count, key, lowerPriority) - leaf->elements);
+    return leaf;
+}
+
+bool PQBTree::isEmpty() const {
+    return _size == 0;
+}
+
+int PQBTree::size() const {
+    return _size;
+}
+
+void PQBTree::clear() {
+    release(_root, _height);
+    _first = new Leaf;
+    _root = _first;
+    _height = 0;
+    _size = 0;
+}
+
+/*
+ * Deletes node and everything under it.
+ */
+void PQBTree::release(void* node, int level) {
+    if (level == 0) {
+        delete static_cast<Leaf*>(node);
+        return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for (int i = 0; i < inner->count; i++) {
+        release(inner->children[i], level - 1);
+    }
+    delete inner;
+}
+
+void PQBTree::debugConfirmInternalTree() const {
+    double infinity = numeric_limits<double>::infinity();
+    if (confirmSubtree(_root, _height, -infinity, infinity) != _size) {
+        error("PQBTree size does not match the elements in the tree!");
+    }
+    int linked = 0;
+    for (const Leaf* leaf = _first; leaf != nullptr; leaf = leaf->next) {
+        linked += leaf->count;
+    }
+    if (linked != _size) {
+        error("PQBTree leaf links skip or repeat elements!");
+    }
+}
+
+/*
+ * Checks the subtree under node, whose priorities must all lie in [low, high], and returns how many
+ * elements it holds.
+ */
+int PQBTree::confirmSubtree(const void* node, int level, double low, double high) const {
+    if (level == 0) {
+        const Leaf* leaf = static_cast<const Leaf*>(node);
+        for (int i = 0; i < leaf->count; i++) {
+            double priority = leaf->elements[i].priority;
+            if (priority < low || priority > high || (i > 0 && priority < leaf->elements[i - 1].priority)) {
+                error("PQBTree leaf out of order at slot " + integerToString(i));
+            }
+        }
+        return leaf->count;
+    }
+
+    const Inner* inner = static_cast<const Inner*>(node);
+    if (inner->count == 0) {
+        error("PQBTree has an empty inner node!");
+    }
+    int total = 0;
+    for (int i = 0; i < inner->count; i++) {
+        double childLow = (i == 0) ? low : inner->lowest[i];
+        double childHigh = (i + 1 < inner->count) ? inner->lowest[i + 1] : high;
+        int count = confirmSubtree(inner->children[i], level - 1, childLow, childHigh);
+        if (count != inner->sizes[i]) {
+            error("PQBTree element count wrong for child " + integerToString(i));
+        }
+        total += count;
+    }
+    return total;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("PQBTree: example from PQHeap writeup, plus rank, select and a range") {
+    PQBTree pq;
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+    EXPECT_ERROR(pq.select(0));
+    EXPECT_EQUAL(pq.rank(5), 0);
+
+    Vector<DataPoint> input = {
+        {"R", 4}, {"A", 5}, {"B", 3}, {"K", 7}, {"G", 2},
+        {"V", 9}, {"T", 1}, {"O", 8}, {"S", 6}, {"S2", 6} };
+    for (const DataPoint& dp : input) {
+        pq.enqueue(dp);
+    }
+    pq.debugConfirmInternalTree();
+    EXPECT_EQUAL(pq.size(), 10);
+    EXPECT_EQUAL(pq.peek(), {"T", 1});
+    EXPECT_EQUAL(pq.select(5), {"S", 6});
+    EXPECT_EQUAL(pq.select(6), {"S2", 6});                      // equal priorities in order of arrival
+    EXPECT_ERROR(pq.select(10));
+    EXPECT_EQUAL(pq.rank(6), 5);
+    EXPECT_EQUAL(pq.rank(6.5), 7);
+    EXPECT_EQUAL(pq.rank(100), 10);
+
+    vector<DataPoint> inRange;
+    pq.forEachInRange(3, 7, [&](const DataPoint& dp) { inRange.push_back(dp); });
+    EXPECT_EQUAL(inRange, { {"B", 3}, {"R", 4}, {"A", 5}, {"S", 6}, {"S2", 6} });
+
+    for (int priority = 1; priority <= 9; priority++) {
+        EXPECT_EQUAL(pq.dequeue().priority, priority);
+        if (priority == 6) {
+            EXPECT_EQUAL(pq.dequeue(), {"S2", 6});
+        }
+    }
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("PQBTree: rank, select and ranges match a sorted reference through many splits") {
+    setRandomSeed(23);
+    PQBTree pq;
+    vector<double> sorted;
+    for (int i = 0; i < 40000; i++) {
+        if (randomChance(0.65) || sorted.empty()) {
+            double priority = (i < 5000) ? i : randomInteger(0, 3000);   // an increasing run, then duplicates
+            pq.enqueue({"", priority});
+            sorted.insert(upper_bound(sorted.begin(), sorted.end(), priority), priority);
+        } else {
+            EXPECT_EQUAL(pq.dequeue().priority, sorted.front());
+            sorted.erase(sorted.begin());
+        }
+        if (i % 4000 == 0) {
+            pq.debugConfirmInternalTree();
+            EXPECT_EQUAL(pq.size(), int(sorted.size()));
+            for (int k = 0; k < int(sorted.size()); k += 97) {
+                EXPECT_EQUAL(pq.select(k).priority, sorted[k]);
+            }
+            for (int p = -1; p <= 5001; p += 113) {
+                int expected = int(lower_bound(sorted.begin(), sorted.end(), p) - sorted.begin());
+                EXPECT_EQUAL(pq.rank(p), expected);
+            }
+            int visited = 0;
+            bool ordered = true;
+            double previous = 1000;
+            pq.forEachInRange(1000, 2000, [&](const DataPoint& dp) {
+                ordered = ordered && dp.priority >= previous && dp.priority < 2000;
+                previous = dp.priority;
+                visited++;
+            });
+            EXPECT(ordered);
+            EXPECT_EQUAL(visited, pq.rank(2000) - pq.rank(1000));
+        }
+    }
+    while (!sorted.empty()) {
+        EXPECT_EQUAL(pq.dequeue().priority, sorted.front());
+        sorted.erase(sorted.begin());
+    }
+    pq.debugConfirmInternalTree();
+    EXPECT(pq.isEmpty());
+    pq.enqueue({"again", 1});
+    pq.clear();
+    EXPECT(pq.isEmpty());
+    pq.debugConfirmInternalTree();
+}
+
+/* Ranks every query priority with the tree, adding up the results so the work is not optimized away. */
+static long rankAll(const PQBTree& tree, const Vector<double>& queries) {
+    long total = 0;
+    for (double priority : queries) {
+        total += tree.rank(priority);
+    }
+    return total;
+}
+
+/* The same with binary search over a sorted Vector, which is what a static data set would use. */
+static long rankAllSorted(const Vector<DataPoint>& sorted, const Vector<double>& queries) {
+    long total = 0;
+    for (double priority : queries) {
+        total += lower_bound(sorted.begin(), sorted.end(), DataPoint{"", priority}, lowerPriority) - sorted.begin();
+    }
+    return total;
+}
+
+STUDENT_TEST("PQBTree: time enqueue and dequeue against PQHeap, and rank against a sorted Vector") {
+    for (int n = 100000; n <= 1000000; n *= 10) {
+        Vector<DataPoint> input;
+        Vector<double> queries;
+        for (int i = 0; i < n; i++) {
+            input.add({"", randomReal(0, 10)});
+            queries.add(randomReal(0, 10));
+        }
+        PQBTree tree;
+        PQHeap heap;
+        TIME_OPERATION(n, fillThenDrain(tree, input));
+        TIME_OPERATION(n, fillThenDrain(heap, input));
+
+        for (const DataPoint& pt : input) {
+            tree.enqueue(pt);
+        }
+        Vector<DataPoint> sorted = input;
+        sort(sorted.begin(), sorted.end(), lowerPriority);
+        long fromTree, fromSorted;
+        TIME_OPERATION(n, fromTree = rankAll(tree, queries));
+        TIME_OPERATION(n, fromSorted = rankAllSorted(sorted, queries));
+        EXPECT_EQUAL(fromTree, fromSorted);
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+
+/**
+ * Priority queue of DataPoints kept in a B+tree ordered by priority, which
+ * besides the frontmost element can answer order-statistic questions: the
+ * element of a given rank, the rank of a given priority, and every element
+ * whose priority falls in a range.
+ *
+ * The elements sit in leaves of up to LEAF_CAPACITY DataPoints each, sorted by
+ * priority and linked left to right, so a range is read off by walking
+ * neighbouring slots of one leaf and then the next. Inner nodes hold up to
+ * INNER_CAPACITY children, and keep in contiguous arrays the smallest priority
+ * under each child and the number of elements under it. A search reads a few
+ * adjacent cache lines per level, and with this fanout a million elements are
+ * only four or five levels deep. The element counts are what let rank and
+ * select skip whole subtrees instead of counting their elements.
+ *
+ * dequeue only ever removes the leftmost element. Leaves and inner nodes that
+ * run empty are dropped, but nodes are never merged. Apart from the root, the
+ * only nodes that can be less than half full are those along the left edge,
+ * which dequeue drains, and the last leaf, which an enqueue past the end of a
+ * full last leaf starts with a single element. Neither costs more than a few
+ * partly empty nodes, so merging would not pay for itself.
+ *
+ * Elements of equal priority are dequeued in the order they were enqueued.
+ */
+class PQBTree {
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    PQBTree();
+
+    /**
+     * Cleans up every node of the tree.
+     */
+    ~PQBTree();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time
+     * O(log n).
+     */
+    void enqueue(DataPoint element);
+
+    /**
+     * Removes and returns the frontmost element. If the priority queue is
+     * empty, this function calls error(). This operation runs in time
+     * O(log n).
+     */
+    DataPoint dequeue();
+
+    /**
+     * Returns, but does not remove, the frontmost element. If the priority
+     * queue is empty, this function calls error(). This operation runs in time
+     * O(1).
+     */
+    const DataPoint& peek() const;
+
+    /**
+     * Returns the element that would be dequeued rank-th, counting from 0 for
+     * the frontmost. If rank is not in [0, size()), this function calls
+     * error(). This operation runs in time O(log n).
+     */
+    const DataPoint& select(int rank) const;
+
+    /**
+     * Returns how many elements have a priority less than the given one, which
+     * is also the rank a new element of that priority would be dequeued at if
+     * it were the first of its priority. This operation runs in time O(log n).
+     */
+    int rank(double priority) const;
+
+    /**
+     * Calls visit(element) on every element whose priority is at least low and
+     * less than high, in the order they would be dequeued. The tree must not be
+     * modified during the walk. This operation runs in time O(log n + k) for k
+     * elements visited.
+     */
+    template <typename Function>
+    void forEachInRange(double low, double high, Function visit) const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue.
+     */
+    void clear();
+
+    /*
+     * Confirms that every leaf is sorted, that every subtree lies between its
+     * neighbours' smallest priorities and that every element count is right.
+     * Raises an error if a problem is found. Intended solely for testing.
+     */
+    void debugConfirmInternalTree() const;
+
+private:
+    static const int LEAF_CAPACITY = 32;
+    static const int INNER_CAPACITY = 32;
+
+    struct Leaf {
+        int count = 0;
+        Leaf* next = nullptr;       // leaf to the right, or nullptr for the last
+        DataPoint elements[LEAF_CAPACITY];
+    };
+
+    /* children[i] is a Leaf* when the node is one level above the leaves and an Inner* otherwise. Every
+     * element under children[i] has a priority of at least lowest[i] and at most lowest[i + 1]. */
+    struct Inner {
+        int count = 0;
+        double lowest[INNER_CAPACITY];
+        int sizes[INNER_CAPACITY];
+        void* children[INNER_CAPACITY];
+    };
+
+    void* insertInto(void* node, int level, DataPoint&& element, double& splitLowest);
+    bool removeFront(void* node, int level, DataPoint& front);
+    int subtreeSize(void* node, int level) const;
+    int findChild(const Inner* inner, double priority, bool pastEqual) const;
+    const Leaf* findLeaf(double priority, int& slot) const; // leaf and slot of the first element >= priority
+    void release(void* node, int level);
+    int confirmSubtree(const void* node, int level, double low, double high) const;
+
+    void* _root;        // a Leaf* while _height is 0, an Inner* otherwise
+    int _height;        // levels of inner nodes above the leaves
+    Leaf* _first;       // leftmost leaf, where the front is
+    int _size;
+
+    DISALLOW_COPYING_OF(PQBTree);
+};
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+/*
+ * The walk starts at the first element not below low and follows the leaf links from there, so apart
+ * from the descent that finds it, each element visited costs one step.
+ */
+template <typename Function>
+void PQBTree::forEachInRange(double low, double high, Function visit) const {
+    int slot;
+    for (const Leaf* leaf = findLeaf(low, slot); leaf != nullptr; leaf = leaf->next, slot = 0) {
+        for (; slot < leaf->count; slot++) {
+            if (!(leaf->elements[slot].priority < high)) {
+                return;
+            }
+            visit(leaf->elements[slot]);
+        }
+    }
+}
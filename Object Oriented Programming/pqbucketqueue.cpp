@@ -0,0 +1,216 @@
+/*
+ * This file, pqbucketqueue, implements the PQBucketQueue class declared in pqbucketqueue.h, followed by its
+ * test cases and a time trial against PQHeap on small integer priorities.
+ */
+#include "pqbucketqueue.h"
+#include "error.h"
+#include "pqheap.h"
+#include "random.h"
+#include "strlib.h"
+#include "testsupport.h"
+#include "SimpleTest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+using namespace std;
+
+/* suitsPriorities always allows at least this many buckets, however few elements there are. */
+const int64_t kMinBucketSpan = 1024;
+
+PQBucketQueue::PQBucketQueue(int lowest, int highest) : _lowest(lowest), _front(0), _numFilled(0) {
+    if (highest < lowest) {
+        error("PQBucketQueue range is empty: highest " + integerToString(highest)
+              + " is below lowest " + integerToString(lowest) + "!");
+    }
+    _buckets.resize(size_t(int64_t(highest) - lowest + 1));
+}
+
+/*
+ * The comparisons are written so that NaN, which fails every comparison, is rejected too.
+ */
+bool PQBucketQueue::accepts(double priority) const {
+    return priority >= _lowest && priority <= _lowest + double(_buckets.size() - 1) && priority == floor(priority);
+}
+
+int PQBucketQueue::bucketOf(double priority) const {
+    if (!accepts(priority)) {
+        error("PQBucketQueue cannot hold priority " + realToString(priority) + "!");
+    }
+    return int(int64_t(priority) - _lowest);
+}
+
+void PQBucketQueue::enqueue(const DataPoint& element) {
+    enqueue(DataPoint(element));
+}
+
+/*
+ * The new element only affects the front if it lands below it, or if the queue was empty.
+ */
+void PQBucketQueue::enqueue(DataPoint&& element) {
+    int bucket = bucketOf(element.priority);
+    _buckets[bucket].push_back(std::move(element));
+    if (_numFilled == 0 || bucket < _front) {
+        _front = bucket;
+    }
+    _numFilled++;
+}
+
+/*
+ * Takes the last element of the front bucket. If that empties the bucket, the front moves forward to
+ * the next bucket with anything in it, so peek never has to search.
+ */
+DataPoint PQBucketQueue::dequeue() {
+    if (isEmpty()) {
+        error("Cannot dequeue because PQBucketQueue is empty!");
+    }
+    vector<DataPoint>& bucket = _buckets[_front];
+    DataPoint result = std::move(bucket.back());
+    bucket.pop_back();
+    _numFilled--;
+
+    if (_numFilled > 0) {
+        while (_buckets[_front].empty()) {
+            _front++;
+        }
+    }
+    return result;
+}
+
+const DataPoint& PQBucketQueue::peek() const {
+    if (isEmpty()) {
+        error("Cannot peek because PQBucketQueue is empty!");
+    }
+    return _buckets[_front].back();
+}
+
+bool PQBucketQueue::isEmpty() const {
+    return _numFilled == 0;
+}
+
+int PQBucketQueue::size() const {
+    return _numFilled;
+}
+
+void PQBucketQueue::clear() {
+    for (vector<DataPoint>& bucket : _buckets) {
+        bucket.clear();
+    }
+    _front = 0;
+    _numFilled = 0;
+}
+
+/*
+ * One pass finds the range and checks that every priority is whole. The range is allowed to be as
+ * large as the input (or kMinBucketSpan, for small inputs) so the buckets never dominate the work.
+ */
+bool PQBucketQueue::suitsPriorities(const Vector<DataPoint>& v, int& lowest, int& highest) {
+    if (v.isEmpty()) {
+        return false;
+    }
+    double low = v[0].priority;
+    double high = v[0].priority;
+    for (const DataPoint& pt : v) {
+        if (!(pt.priority == floor(pt.priority))) {
+            return false;
+        }
+        low = min(low, pt.priority);
+        high = max(high, pt.priority);
+    }
+    if (low < numeric_limits<int>::min() || high > numeric_limits<int>::max()
+            || high - low + 1 > double(max<int64_t>(kMinBucketSpan, v.size()))) {
+        return false;
+    }
+    lowest = int(low);
+    highest = int(high);
+    return true;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("PQBucketQueue: dequeues in priority order, front moves back on lower enqueue") {
+    PQBucketQueue pq(1954, 2023);
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.peek());
+    EXPECT_ERROR(pq.dequeue());
+
+    pq.enqueue({"c", 2000});
+    pq.enqueue({"a", 1990});
+    pq.enqueue({"d", 2023});
+    EXPECT_EQUAL(pq.peek(), {"a", 1990});
+    EXPECT_EQUAL(pq.dequeue(), {"a", 1990});
+    EXPECT_EQUAL(pq.peek(), {"c", 2000});
+
+    pq.enqueue({"b", 1954});                // below the current front
+    EXPECT_EQUAL(pq.dequeue(), {"b", 1954});
+    EXPECT_EQUAL(pq.dequeue(), {"c", 2000});
+    EXPECT_EQUAL(pq.dequeue(), {"d", 2023});
+    EXPECT(pq.isEmpty());
+
+    pq.enqueue({"e", 2010});
+    pq.clear();
+    EXPECT_EQUAL(pq.size(), 0);
+}
+
+STUDENT_TEST("PQBucketQueue: rejects priorities outside the range or not whole") {
+    EXPECT_ERROR(PQBucketQueue(5, 4));
+    PQBucketQueue pq(-3, 3);
+    EXPECT(pq.accepts(-3) && pq.accepts(0) && pq.accepts(3));
+    EXPECT(!pq.accepts(4) && !pq.accepts(-4) && !pq.accepts(0.5) && !pq.accepts(nan("")));
+    EXPECT_ERROR(pq.enqueue({"too high", 4}));
+    EXPECT_ERROR(pq.enqueue({"fraction", 1.5}));
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("PQBucketQueue: stress test against PQHeap, cycle random elements in and out") {
+    setRandomSeed(14);
+    PQHeap reference;
+    PQBucketQueue pq(-50, 50);
+    for (int i = 0; i < 20000; i++) {
+        if (randomChance(0.6) || reference.isEmpty()) {
+            DataPoint elem = {"", double(randomInteger(-50, 50))};
+            reference.enqueue(elem);
+            pq.enqueue(elem);
+        } else {
+            double expected = reference.dequeue().priority;
+            EXPECT_EQUAL(pq.dequeue().priority, expected);
+        }
+        EXPECT_EQUAL(pq.size(), reference.size());
+    }
+}
+
+STUDENT_TEST("PQBucketQueue: suitsPriorities accepts small whole ranges only") {
+    int lowest, highest;
+    Vector<DataPoint> years = { {"a", 1999}, {"b", 1954}, {"c", 2023} };
+    EXPECT(PQBucketQueue::suitsPriorities(years, lowest, highest));
+    EXPECT_EQUAL(lowest, 1954);
+    EXPECT_EQUAL(highest, 2023);
+
+    Vector<DataPoint> fractional = { {"a", 1}, {"b", 2.5} };
+    EXPECT(!PQBucketQueue::suitsPriorities(fractional, lowest, highest));
+
+    Vector<DataPoint> spread = { {"a", 0}, {"b", 1e6} };
+    EXPECT(!PQBucketQueue::suitsPriorities(spread, lowest, highest));
+
+    Vector<DataPoint> huge = { {"a", 1e12} };
+    EXPECT(!PQBucketQueue::suitsPriorities(huge, lowest, highest));
+
+    Vector<DataPoint> none;
+    EXPECT(!PQBucketQueue::suitsPriorities(none, lowest, highest));
+}
+
+STUDENT_TEST("PQBucketQueue: time against PQHeap with 8 and 100 distinct priorities") {
+    for (int n = 100000; n <= 10000000; n *= 10) {
+        for (int levels : { 8, 100 }) {
+            Vector<DataPoint> input;
+            for (int i = 0; i < n; i++) {
+                input.add({"", double(randomInteger(0, levels - 1))});
+            }
+            PQHeap heap;
+            PQBucketQueue buckets(0, levels - 1);
+            TIME_OPERATION(n, fillThenDrain(heap, input));
+            TIME_OPERATION(n, fillThenDrain(buckets, input));
+        }
+    }
+}
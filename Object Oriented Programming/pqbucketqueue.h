@@ -0,0 +1,101 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "vector.h"
+#include <vector>
+
+/**
+ * Priority queue of DataPoints whose priorities are integers in a fixed range,
+ * implemented as a bucket queue.
+ *
+ * There is one bucket per possible priority, and the queue remembers the
+ * lowest bucket that is not empty. enqueue appends to the element's bucket
+ * with no comparisons at all. dequeue takes from the remembered bucket and, if
+ * that empties it, walks forward to the next non-empty one. When priorities
+ * are dequeued in nondecreasing order, which is the case for sorting and for
+ * monotone uses such as event simulation, that walk crosses each bucket once,
+ * so every operation is O(1) amortized (plus one pass over the range). An
+ * enqueue below the current front just moves the front back.
+ *
+ * The range is fixed when the queue is created and costs one empty bucket per
+ * value, so it suits small ranges such as years or severity levels. Elements
+ * of equal priority are dequeued in reverse order of arrival.
+ */
+class PQBucketQueue {
+public:
+    /**
+     * Creates a new, empty priority queue for priorities lowest to highest,
+     * inclusive. If highest is less than lowest, this function calls error().
+     */
+    PQBucketQueue(int lowest, int highest);
+
+    /**
+     * Returns whether priority can be stored in this queue: it must be a whole
+     * number between lowest and highest.
+     */
+    bool accepts(double priority) const;
+
+    /**
+     * Adds a new element into the queue. If its priority is not accepted, this
+     * function calls error(). This operation runs in time O(1).
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const DataPoint& element);
+    void enqueue(DataPoint&& element);
+
+    /**
+     * Removes and returns the element with the lowest priority. If the priority
+     * queue is empty, this function calls error().
+     *
+     * This operation runs in amortized time O(1) when priorities are dequeued
+     * in nondecreasing order; in general it may scan up to highest - lowest
+     * empty buckets.
+     *
+     * @return The frontmost element, which is moved out of the queue.
+     */
+    DataPoint dequeue();
+
+    /**
+     * Returns, but does not remove, the element that is frontmost. If the
+     * priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     */
+    const DataPoint& peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue. Buckets keep their memory
+     * for reuse. This operation runs in time O(n + highest - lowest).
+     */
+    void clear();
+
+    /**
+     * Given the priorities in v, decides whether a PQBucketQueue is a good way
+     * to order them: every priority must be a whole number, and the range they
+     * span must be small next to v.size(), so the empty buckets cost no more than
+     * the elements do. If so, stores the range in lowest and highest and returns
+     * true. Runs in time O(n).
+     */
+    static bool suitsPriorities(const Vector<DataPoint>& v, int& lowest, int& highest);
+
+private:
+    int bucketOf(double priority) const; // index of priority's bucket, calling error() if it is not accepted
+
+    int _lowest;                                // priority of bucket 0
+    std::vector<std::vector<DataPoint>> _buckets; // _buckets[i] holds priority _lowest + i
+    int _front;                                 // lowest non-empty bucket, meaningful only if not empty
+    int _numFilled;                             // number of elements in all buckets
+
+    DISALLOW_COPYING_OF(PQBucketQueue);
+};
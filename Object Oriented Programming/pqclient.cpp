@@ -4,58 +4,350 @@
  * test the efficiency of our differnt classes, PQarray, PQheap.
  */
 #include "pqclient.h"
+#include "boundedtopk.h"
+#include "error.h"
 #include "pqarray.h"
+#include "pqbucketqueue.h"
 #include "pqheap.h"
+#include "staticpqheap.h"
 #include "vector.h"
 #include "strlib.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
 #include <sstream>
+#include <thread>
+#include <vector>
+#include "testsupport.h"
 #include "SimpleTest.h"
 using namespace std;
 
-/* This function, PQsort, takes a vector of data points, and enques all those elements, into
- * one of our queues then performs the inverse, dequeuing all those elements back into the vector, to
- * obtain a vector, sorted according to our sorting priorities.
+/* Helpers for the in-place heapsort used by pqSort. They treat a raw array as a max-heap
+ * on priority, so that repeatedly moving the root to the end of the unsorted region leaves
+ * the array in increasing order.
  */
-void pqSort(Vector<DataPoint>& v) {
-    PQHeap pq;
+namespace {
+    /* Treats index hole of the n-element heap starting at elems as empty, pulls the larger
+     * child up into it while that child outranks element, and then writes element into the
+     * final hole.
+     */
+    void siftDownMax(DataPoint* elems, int hole, int n, DataPoint&& element) {
+        while (true) {
+            int child = 2 * hole + 1;
+            if (child >= n) {
+                break;
+            }
+            if (child + 1 < n && elems[child + 1].priority > elems[child].priority) {
+                child++;
+            }
+            if (!(elems[child].priority > element.priority)) {
+                break;
+            }
+            elems[hole] = std::move(elems[child]);
+            hole = child;
+        }
+        elems[hole] = std::move(element);
+    }
+
+    /* Heapsorts the n elements starting at elems into increasing order of priority, moving
+     * elements within the array only.
+     */
+    void heapSortInPlace(DataPoint* elems, int n) {
+        for (int i = n / 2 - 1; i >= 0; i--) {
+            DataPoint element = std::move(elems[i]);
+            siftDownMax(elems, i, n, std::move(element));
+        }
+        for (int end = n - 1; end > 0; end--) {
+            DataPoint last = std::move(elems[end]);
+            elems[end] = std::move(elems[0]);
+            siftDownMax(elems, 0, end, std::move(last));
+        }
+    }
+
+    /* No call starts more worker threads than this, however many are asked for. */
+    const int kMaxWorkers = 64;
+
+    /* Resolves a requested thread count, where anything below 1 means one per hardware thread. */
+    int workerCount(int numThreads) {
+        if (numThreads > 0) {
+            return min(numThreads, kMaxWorkers);
+        }
+        return max(1, min(int(thread::hardware_concurrency()), kMaxWorkers));
+    }
+
+    /* Runs work(0) ... work(numWorkers - 1) on their own threads and waits for all of them.
+     * error() throws, and an exception cannot cross a thread boundary, so the first one any
+     * worker raised is carried back and rethrown here once every thread has been joined.
+     */
+    template <typename Work>
+    void runWorkers(int numWorkers, Work work) {
+        vector<exception_ptr> failures(numWorkers);
+        vector<thread> threads;
+        threads.reserve(numWorkers);
+        for (int i = 0; i < numWorkers; i++) {
+            threads.emplace_back([&work, &failures, i] {
+                try {
+                    work(i);
+                } catch (...) {
+                    failures[i] = current_exception();
+                }
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+        for (const exception_ptr& failure : failures) {
+            if (failure) {
+                rethrow_exception(failure);
+            }
+        }
+    }
 
-    /* Using the Priority Queue data structure as a tool to sort, neat! */
+    /* A topK for at most this many points keeps them in a StaticPQHeap inside its BoundedTopK, on the
+     * stack, instead of in a BasicPQHeap that allocates its array. */
+    const int kMaxStaticTopK = 64;
 
-    /* Add all the elements to the priority queue. */
-    for (int i = 0; i < v.size(); i++) {
-        pq.enqueue(v[i]);
+    /* Hands scan an empty BoundedTopK of Ts that keeps the k best under PriorityThenLabelRank, and
+     * returns what it kept, highest first. Both kinds of BoundedTopK rank the same way, so which one a
+     * given k gets makes no difference to the result.
+     */
+    template <typename T, typename Scan>
+    Vector<T> keepBest(int k, Scan scan) {
+        k = max(k, 0);
+        if (k <= kMaxStaticTopK) {
+            BoundedTopK<T, PriorityThenLabelRank, StaticPQHeap<kMaxStaticTopK, T, PriorityThenLabelRank>> best(k);
+            scan(best);
+            return best.takeDescending();
+        }
+        BoundedTopK<T, PriorityThenLabelRank> best(k);
+        scan(best);
+        return best.takeDescending();
     }
 
-    /* Extract all the elements from the priority queue. Due
-     * to the priority queue property, we know that we will get
-     * these elements in sorted order, in order of increasing priority
-     * value. Store elements back into vector, now in sorted order.
+    /* Runs shorter than this are not worth a thread of their own. */
+    const int kMinParallelRunLength = 1 << 14;
+
+    /* The element at index next of the merge buffer is the smallest not yet merged from run. */
+    struct RunHead {
+        double priority;
+        int run;
+        int next;
+    };
+
+    /* Orders run heads by priority, and equal priorities by run, so the merge is deterministic. */
+    struct RunHeadOrder {
+        bool operator()(const RunHead& lhs, const RunHead& rhs) const {
+            if (lhs.priority != rhs.priority) {
+                return lhs.priority < rhs.priority;
+            }
+            return lhs.run < rhs.run;
+        }
+    };
+
+    /* Sorts v with numRuns concurrent heapsorts followed by a k-way merge. Each worker moves its
+     * slice of v into the shared buffer and heapsorts it there; the merge then moves the elements
+     * back into v in order. A run's head only leaves the PQHeap when the run is used up; otherwise
+     * it is replaced by the run's next element with a single percolate-down.
      */
-    for (int i = 0; !pq.isEmpty(); i++) {
-        v[i] = pq.dequeue();
+    void parallelMergeSort(Vector<DataPoint>& v, int numRuns) {
+        int n = v.size();
+        vector<int> runStart(numRuns + 1);
+        for (int run = 0; run <= numRuns; run++) {
+            runStart[run] = int(int64_t(n) * run / numRuns);
+        }
+
+        vector<DataPoint> buffer(n);
+        DataPoint* elems = &v[0];
+        runWorkers(numRuns, [&](int run) {
+            for (int i = runStart[run]; i < runStart[run + 1]; i++) {
+                buffer[i] = std::move(elems[i]);
+            }
+            heapSortInPlace(buffer.data() + runStart[run], runStart[run + 1] - runStart[run]);
+        });
+
+        BasicPQHeap<RunHead, RunHeadOrder> heads;
+        for (int run = 0; run < numRuns; run++) {
+            heads.enqueue({ buffer[runStart[run]].priority, run, runStart[run] });
+        }
+        for (int out = 0; out < n; out++) {
+            RunHead head = heads.peek();
+            elems[out] = std::move(buffer[head.next]);
+            head.next++;
+            if (head.next < runStart[head.run + 1]) {
+                head.priority = buffer[head.next].priority;
+                heads.replaceTop(head);
+            } else {
+                heads.dequeue();
+            }
+        }
     }
 }
 
-/* This function, topK takes a stream of DataPoints, and uses a queue to retain only the 10 "best"
- * DataPoints according to our set priorities. THen, is dequeues these 10 DataPoints returning them as a vector from biggest
- * to smallest.
+/* This function, PQsort, sorts a vector of data points by priority without any buffer besides the vector
+ * itself. In the default mode the vector is turned into a max-heap in place and the largest remaining
+ * element is repeatedly swapped to the end of the unsorted region, which is the same enqueue/dequeue
+ * process PQHeap performs, just without copying the elements into a separate queue. INTROSORT mode hands
+ * the vector to std::sort instead, and PARALLEL_MERGE splits the heapsort across threads and merges the runs.
+ * AUTO drops the points into a PQBucketQueue and reads them back out when the priorities are small whole numbers.
+ */
+void pqSort(Vector<DataPoint>& v, PQSortMode mode, int numThreads) {
+    if (v.size() < 2) {
+        return;
+    }
+
+    int lowest, highest;
+    if (mode == PQSortMode::AUTO && PQBucketQueue::suitsPriorities(v, lowest, highest)) {
+        PQBucketQueue buckets(lowest, highest);
+        for (DataPoint& pt : v) {
+            buckets.enqueue(std::move(pt));
+        }
+        for (DataPoint& pt : v) {
+            pt = buckets.dequeue();
+        }
+        return;
+    }
+
+    if (mode == PQSortMode::PARALLEL_MERGE) {
+        int numRuns = min(workerCount(numThreads), v.size() / kMinParallelRunLength);
+        if (numRuns > 1) {
+            parallelMergeSort(v, numRuns);
+            return;
+        }
+    }
+
+    if (mode == PQSortMode::INTROSORT) {
+        sort(v.begin(), v.end(), [](const DataPoint& lhs, const DataPoint& rhs) {
+            return lhs.priority < rhs.priority;
+        });
+    } else {
+        /* Vector storage is contiguous, so the heap works on it through a raw pointer
+         * and skips the bounds check on every access. */
+        heapSortInPlace(&v[0], v.size());
+    }
+}
+
+/* This function, topK takes a stream of DataPoints, and uses a BoundedTopK to retain only the k "best"
+ * DataPoints according to our set priorities. Each point is compared once against the weakest point kept so far
+ * and either rejected right away or swapped in with a single percolate-down. Then, the kept DataPoints are
+ * returned as a vector from biggest to smallest. For the small k the demos ask for, keepBest keeps the points
+ * on the stack, so the BoundedTopK itself never allocates.
  */
 Vector<DataPoint> topK(istream& stream, int k) {
-    PQHeap pq;
-    DataPoint cur;
-    while (stream >> cur) {
-        pq.enqueue(cur);
-        if (pq.size() > k){
-            pq.dequeue();
+    return keepBest<DataPoint>(k, [&](auto& best) {
+        DataPoint cur;
+        while (stream >> cur) {
+            best.offer(std::move(cur)); // cur is reassigned by the next read
+        }
+    });
+}
+
+/* This overload of topK works exactly like the one above, but pulls its DataPoints from a binary
+ * reader, which decodes records straight out of a buffer instead of parsing text.
+ */
+Vector<DataPoint> topK(DataPointReader& reader, int k) {
+    return keepBest<DataPoint>(k, [&](auto& best) {
+        DataPoint cur;
+        while (reader.read(cur)) {
+            best.offer(std::move(cur));
+        }
+    });
+}
+
+/* This overload of topK keeps DataPointViews in its BoundedTopK, so the whole scan only moves string_views
+ * around. Once the k winners are known, their labels are copied (and unescaped) out of the mapping.
+ */
+Vector<DataPoint> topK(MappedDataPointReader& reader, int k) {
+    Vector<DataPointView> winners = keepBest<DataPointView>(k, [&](auto& best) {
+        DataPointView cur;
+        while (reader.read(cur)) {
+            best.offer(cur);
         }
+    });
+    Vector<DataPoint> result(winners.size());
+    for (int i = 0; i < winners.size(); i++) {
+        result[i] = materialize(winners[i]);
     }
+    return result;
+}
+
+/* This version of topK gives each worker thread a contiguous slice of the vector and its own BoundedTopK, so
+ * the workers share nothing but read-only input. Their winners, at most k per worker, are then offered to one
+ * last BoundedTopK. Offering by const reference means only points that are actually kept get copied.
+ */
+Vector<DataPoint> parallelTopK(const Vector<DataPoint>& v, int k, int numThreads) {
+    int numWorkers = max(1, min(workerCount(numThreads), v.size()));
+    vector<Vector<DataPoint>> partial(numWorkers);
+    runWorkers(numWorkers, [&](int worker) {
+        int begin = int(int64_t(v.size()) * worker / numWorkers);
+        int end = int(int64_t(v.size()) * (worker + 1) / numWorkers);
+        partial[worker] = keepBest<DataPoint>(k, [&](auto& best) {
+            for (int i = begin; i < end; i++) {
+                best.offer(v[i]);
+            }
+        });
+    });
+
+    return keepBest<DataPoint>(k, [&](auto& best) {
+        for (Vector<DataPoint>& winners : partial) {
+            for (DataPoint& pt : winners) {
+                best.offer(std::move(pt));
+            }
+        }
+    });
+}
 
-    Vector<DataPoint> result(pq.size());
+/* This version of topK splits the mapped file into byte ranges on the calling thread and ranks them with
+ * the version below.
+ */
+Vector<DataPoint> parallelTopK(const MappedDataPointFile& file, int k, int numThreads) {
+    return parallelTopK(file, splitDataPointFile(file, workerCount(numThreads)), k);
+}
 
-    for (int i = pq.size() - 1; i >= 0 ; i--){
-        result[i] = pq.dequeue();
+/* This version of topK runs the zero-copy scan from the mapped topK on each byte range in its own thread,
+ * merging the views before anything is materialized. A worker whose reader does not stop exactly where the
+ * next range begins, or that hits what looks like a malformed record, has caught a bad text split (one that
+ * falls inside a label such as "x}{"), in which case the ranges cannot be trusted and the file is ranked on
+ * one thread instead. If the file really is malformed, that scan reports it.
+ */
+Vector<DataPoint> parallelTopK(const MappedDataPointFile& file, const vector<size_t>& boundaries, int k) {
+    if (boundaries.size() < 2 || boundaries.size() - 1 > size_t(kMaxWorkers)) {
+        error("parallelTopK: boundaries must describe between 1 and " + integerToString(kMaxWorkers) + " ranges!");
+    }
+    int numWorkers = int(boundaries.size()) - 1;
+    vector<Vector<DataPointView>> partial(numWorkers);
+    vector<char> splitCleanly(numWorkers, false);
+    runWorkers(numWorkers, [&](int worker) {
+        MappedDataPointReader reader(file, boundaries[worker], boundaries[worker + 1]);
+        try {
+            partial[worker] = keepBest<DataPointView>(k, [&](auto& best) {
+                DataPointView cur;
+                while (reader.read(cur)) {
+                    best.offer(cur);
+                }
+            });
+            splitCleanly[worker] = reader.position() == boundaries[worker + 1];
+        } catch (const ErrorException&) {
+            // splitCleanly[worker] stays false
+        }
+    });
+
+    if (find(splitCleanly.begin(), splitCleanly.end(), false) != splitCleanly.end()) {
+        MappedDataPointReader reader(file);
+        return topK(reader, k);
     }
 
+    Vector<DataPointView> winners = keepBest<DataPointView>(k, [&](auto& best) {
+        for (const Vector<DataPointView>& workerWinners : partial) {
+            for (const DataPointView& view : workerWinners) {
+                best.offer(view);
+            }
+        }
+    });
+    Vector<DataPoint> result(winners.size());
+    for (int i = 0; i < winners.size(); i++) {
+        result[i] = materialize(winners[i]);
+    }
     return result;
 }
 
@@ -82,6 +374,17 @@ stringstream asStream(int start, int stop) {
     return result;
 }
 
+/* Helper function that, given a list of data points, produces a binary-format stream from them. */
+stringstream asBinaryStream(const Vector<DataPoint>& dataPoints) {
+    stringstream result;
+    DataPointWriter writer(result);
+    for (const DataPoint& pt: dataPoints) {
+        writer.write(pt);
+    }
+    writer.flush();
+    return result;
+}
+
 /* Helper function to fill vector with n random DataPoints. */
 void fillVector(Vector<DataPoint>& vec, int n) {
     vec.clear();
@@ -116,6 +419,305 @@ STUDENT_TEST("topK: time trial") {
 }
 
 
+STUDENT_TEST("pqSort: both modes sort random input, duplicates and tiny vectors") {
+    setRandomSeed(2024);
+    for (PQSortMode mode : { PQSortMode::IN_PLACE_HEAP, PQSortMode::INTROSORT }) {
+        for (int n : { 0, 1, 2, 3, 10, 257, 1000 }) {
+            Vector<DataPoint> v;
+            Vector<double> expected;
+            for (int i = 0; i < n; i++) {
+                double priority = randomInteger(0, n / 4);
+                v.add({ integerToString(i), priority });
+                expected.add(priority);
+            }
+            expected.sort();
+
+            pqSort(v, mode);
+            EXPECT_EQUAL(v.size(), n);
+            for (int i = 0; i < n; i++) {
+                EXPECT_EQUAL(v[i].priority, expected[i]);
+            }
+        }
+    }
+}
+
+STUDENT_TEST("pqSort: AUTO uses buckets for small whole priorities and still sorts anything else") {
+    setRandomSeed(2026);
+    Vector<Vector<DataPoint>> inputs(3);
+    for (int i = 0; i < 5000; i++) {
+        inputs[0].add({ integerToString(i), double(randomInteger(1954, 2023)) });   // years: buckets
+        inputs[1].add({ integerToString(i), double(randomInteger(-3, 3)) });        // levels: buckets
+        inputs[2].add({ integerToString(i), randomReal(0, 100) });                  // reals: heap
+    }
+    for (const Vector<DataPoint>& input : inputs) {
+        Vector<DataPoint> expected = input, v = input;
+        pqSort(expected, PQSortMode::INTROSORT);
+        pqSort(v, PQSortMode::AUTO);
+        bool samePriorities = true;
+        for (int i = 0; i < v.size(); i++) {
+            samePriorities = samePriorities && v[i].priority == expected[i].priority;
+        }
+        EXPECT(samePriorities);
+    }
+}
+
+STUDENT_TEST("pqSort: time AUTO vs in-place heapsort on years") {
+    for (int n = 1000000; n <= 4000000; n *= 2) {
+        Vector<DataPoint> heapInput;
+        for (int i = 0; i < n; i++) {
+            heapInput.add({ "", double(randomInteger(1954, 2023)) });
+        }
+        Vector<DataPoint> autoInput = heapInput;
+        TIME_OPERATION(n, pqSort(heapInput, PQSortMode::IN_PLACE_HEAP));
+        TIME_OPERATION(n, pqSort(autoInput, PQSortMode::AUTO));
+        EXPECT_EQUAL(autoInput.size(), heapInput.size());
+    }
+}
+
+STUDENT_TEST("pqSort: parallel merge matches a single-threaded sort for any thread count") {
+    setRandomSeed(2025);
+    for (int n : { 0, 1, 1000, (1 << 14) * 2 - 1, 100003 }) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({ integerToString(i), double(randomInteger(0, n / 8)) });
+        }
+        Vector<DataPoint> expected = input;
+        pqSort(expected, PQSortMode::INTROSORT);
+
+        for (int threads : { 0, 1, 2, 3, 4, 7 }) {
+            Vector<DataPoint> v = input;
+            pqSort(v, PQSortMode::PARALLEL_MERGE, threads);
+            EXPECT_EQUAL(v.size(), n);
+            bool samePriorities = true;
+            for (int i = 0; i < n; i++) {
+                samePriorities = samePriorities && v[i].priority == expected[i].priority;
+            }
+            EXPECT(samePriorities);
+
+            /* Same points, not just the same priorities: every label comes back exactly once. */
+            Vector<int> timesSeen(n, 0);
+            for (const DataPoint& pt : v) {
+                timesSeen[stringToInteger(pt.label)]++;
+            }
+            EXPECT_EQUAL(timesSeen, Vector<int>(n, 1));
+        }
+    }
+}
+
+STUDENT_TEST("pqSort: time parallel merge from 1 to N threads on millions of elements") {
+    int n = 4000000;
+    Vector<DataPoint> input;
+    fillVector(input, n);
+    int maxThreads = max(8, int(thread::hardware_concurrency()));
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        Vector<DataPoint> v = input;
+        TIME_OPERATION(threads, pqSort(v, PQSortMode::PARALLEL_MERGE, threads));
+        EXPECT(v[0].priority <= v[n / 2].priority && v[n / 2].priority <= v[n - 1].priority);
+    }
+}
+
+STUDENT_TEST("pqSort: time in-place heapsort vs introsort on millions of elements") {
+    for (int n = 1000000; n <= 4000000; n *= 2) {
+        Vector<DataPoint> heapInput;
+        fillVector(heapInput, n);
+        Vector<DataPoint> introInput = heapInput;
+        TIME_OPERATION(n, pqSort(heapInput, PQSortMode::IN_PLACE_HEAP));
+        TIME_OPERATION(n, pqSort(introInput, PQSortMode::INTROSORT));
+        EXPECT_EQUAL(heapInput, introInput);
+    }
+}
+
+
+STUDENT_TEST("topK: binary reader overload matches the text stream version") {
+    Vector<DataPoint> points;
+    fillVector(points, 5000);
+    for (int i = 0; i < points.size(); i++) {
+        points[i].label = "point " + integerToString(i);
+    }
+
+    /* The text format rounds priorities to 16 digits while the binary one is exact,
+     * so the results are matched by label. */
+    for (int k : { 0, 1, 10, 5000, 6000 }) {
+        stringstream text = asStream(points);
+        stringstream binary = asBinaryStream(points);
+        DataPointReader reader(binary);
+        Vector<DataPoint> fromText = topK(text, k);
+        Vector<DataPoint> fromBinary = topK(reader, k);
+        EXPECT_EQUAL(fromBinary.size(), fromText.size());
+        for (int i = 0; i < fromText.size(); i++) {
+            EXPECT_EQUAL(fromBinary[i].label, fromText[i].label);
+        }
+    }
+}
+
+STUDENT_TEST("topK: k on either side of the stack-allocated cutoff gives the same ranking, ties included") {
+    Vector<DataPoint> points;
+    for (int i = 0; i < 5000; i++) {
+        points.add({ "p" + integerToString(randomInteger(0, 999)), double(randomInteger(0, 9)) });
+    }
+    stringstream all = asStream(points);
+    Vector<DataPoint> ranking = topK(all, 200);
+
+    for (int k = 0; k <= 70; k++) {
+        stringstream text = asStream(points);
+        EXPECT_EQUAL(topK(text, k), ranking.subList(0, k));
+    }
+}
+
+STUDENT_TEST("topK: time text stream vs binary reader") {
+    int k = 10;
+    for (int n = 200000; n < 2000000; n *= 2) {
+        Vector<DataPoint> input, textResult, binaryResult;
+        fillVector(input, n);
+        stringstream text = asStream(input);
+        stringstream binary = asBinaryStream(input);
+        DataPointReader reader(binary);
+        TIME_OPERATION(n, textResult = topK(text, k));
+        TIME_OPERATION(n, binaryResult = topK(reader, k));
+        EXPECT_EQUAL(binaryResult.size(), textResult.size());
+    }
+}
+
+
+STUDENT_TEST("topK: memory-mapped text and binary files match the stream version") {
+    Vector<DataPoint> points;
+    fillVector(points, 20000);
+    for (int i = 0; i < points.size(); i++) {
+        points[i].label = "point \"" + integerToString(i) + "\"";
+    }
+
+    for (bool binary : { false, true }) {
+        string path = writeScratchFile("pqclient-test", points, binary);
+        for (int k : { 0, 1, 10, 25000 }) {
+            MappedDataPointFile file(path);
+            MappedDataPointReader reader(file);
+            stringstream text = asStream(points);
+            Vector<DataPoint> fromMapping = topK(reader, k);
+            Vector<DataPoint> fromStream = topK(text, k);
+            EXPECT_EQUAL(fromMapping.size(), fromStream.size());
+            for (int i = 0; i < fromStream.size(); i++) {
+                EXPECT_EQUAL(fromMapping[i].label, fromStream[i].label);
+            }
+        }
+        remove(path.c_str());
+    }
+}
+
+STUDENT_TEST("topK: time text stream vs memory-mapped text and binary files") {
+    int k = 10;
+    for (int n = 200000; n < 2000000; n *= 2) {
+        Vector<DataPoint> input, result;
+        fillVector(input, n);
+        for (int i = 0; i < n; i++) {
+            input[i].label = "a label long enough to need its own heap allocation " + integerToString(i);
+        }
+        stringstream text = asStream(input);
+        TIME_OPERATION(n, result = topK(text, k));
+
+        for (bool binary : { false, true }) {
+            string path = writeScratchFile("pqclient-test", input, binary);
+            {
+                MappedDataPointFile file(path);
+                MappedDataPointReader reader(file);
+                TIME_OPERATION(n, result = topK(reader, k));
+                EXPECT_EQUAL(result.size(), k);
+            }
+            remove(path.c_str());
+        }
+    }
+}
+
+
+STUDENT_TEST("parallelTopK: matches topK exactly for any thread count, even with many ties") {
+    /* Only five distinct priorities, so almost every cut between winners and losers falls
+     * inside a tie and the label order decides which points make it. */
+    Vector<DataPoint> points;
+    for (int i = 0; i < 5000; i++) {
+        points.add({ "p" + integerToString(randomInteger(0, 999)), double(randomInteger(0, 4)) });
+    }
+
+    for (int k : { 0, 1, 7, 1000, 6000 }) {
+        stringstream text = asStream(points);
+        Vector<DataPoint> expected = topK(text, k);
+        for (int threads = 1; threads <= 7; threads++) {
+            EXPECT_EQUAL(parallelTopK(points, k, threads), expected);
+        }
+        EXPECT_EQUAL(parallelTopK(points, k), expected);
+    }
+
+    Vector<DataPoint> none;
+    EXPECT_EQUAL(parallelTopK(none, 3, 4).size(), 0);
+}
+
+STUDENT_TEST("parallelTopK: text and binary files match topK exactly for any thread count") {
+    Vector<DataPoint> points;
+    for (int i = 0; i < 5000; i++) {
+        points.add({ "p {\"" + integerToString(randomInteger(0, 999)) + "\"}", double(randomInteger(0, 4)) });
+    }
+
+    for (bool binary : { false, true }) {
+        string path = writeScratchFile("pqclient-test", points, binary);
+        {
+            MappedDataPointFile file(path);
+            for (int k : { 0, 1, 7, 1000, 6000 }) {
+                stringstream text = asStream(points);
+                Vector<DataPoint> expected = topK(text, k);
+                for (int threads : { 1, 2, 3, 5, 8, 64 }) {
+                    EXPECT_EQUAL(parallelTopK(file, k, threads), expected);
+                }
+                EXPECT_EQUAL(parallelTopK(file, splitDataPointFile(file, 4), k), expected);
+            }
+            EXPECT_ERROR(parallelTopK(file, vector<size_t>{ 0 }, 1));
+            EXPECT_ERROR(parallelTopK(file, splitDataPointFile(file, 65), 1));
+        }
+        remove(path.c_str());
+    }
+}
+
+STUDENT_TEST("parallelTopK: labels that look like record starts fall back instead of failing") {
+    /* Every label ends in }{, so with its closing quote it holds the }{" the text splitter takes
+     * for the start of a record, and a reader started there fails on what follows. */
+    Vector<DataPoint> points;
+    for (int i = 0; i < 5000; i++) {
+        points.add({ "x" + integerToString(i % 97) + "}{", double(randomInteger(0, 99)) });
+    }
+
+    string path = writeScratchFile("pqclient-test", points, false);
+    {
+        MappedDataPointFile file(path);
+        stringstream text = asStream(points);
+        Vector<DataPoint> expected = topK(text, 10);
+        for (int threads : { 2, 3, 8, 10000 }) {
+            EXPECT_EQUAL(parallelTopK(file, 10, threads), expected);
+        }
+    }
+    remove(path.c_str());
+}
+
+STUDENT_TEST("parallelTopK: time 1 to N threads on a vector and a binary file") {
+    int n = 4000000;
+    int k = 100;
+    Vector<DataPoint> input, result;
+    fillVector(input, n);
+    string path = writeScratchFile("pqclient-test", input, true);
+    {
+        MappedDataPointFile file(path);
+        int maxThreads = max(8, int(thread::hardware_concurrency()));
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            TIME_OPERATION(threads, result = parallelTopK(input, k, threads));
+            EXPECT_EQUAL(result.size(), k);
+
+            /* Finding binary boundaries walks every record on one thread, so it is timed on its own
+             * and the scaling numbers are the parallel scan alone. */
+            vector<size_t> boundaries;
+            TIME_OPERATION(threads, boundaries = splitDataPointFile(file, threads));
+            TIME_OPERATION(threads, result = parallelTopK(file, boundaries, k));
+            EXPECT_EQUAL(result.size(), k);
+        }
+    }
+    remove(path.c_str());
+}
+
 /* * * * * Provided Tests Below This Point * * * * */
 
 PROVIDED_TEST("pqSort: vector of random elements") {
@@ -1,17 +1,54 @@
 #pragma once
 #include "datapoint.h"
+#include "datapointstream.h"
+#include "mappeddatapoints.h"
 #include "vector.h"
+#include <cstddef>
 #include <istream>
+#include <vector>
 
 
+/**
+ * Strategies pqSort can use to order a Vector.
+ *
+ *   IN_PLACE_HEAP  Heapsort performed directly in the caller's Vector: the
+ *                  Vector itself is arranged into a heap, so there is no second
+ *                  buffer and no allocation at all. O(N log N) worst case.
+ *   INTROSORT      std::sort (quicksort that falls back to heapsort on bad
+ *                  pivots), also in place. Usually faster on random input and
+ *                  kept so the two can be compared on large sorts.
+ *   PARALLEL_MERGE The Vector is cut into one run per worker thread, the runs
+ *                  are heapsorted concurrently, and a PQHeap holding the head
+ *                  of each run merges them back into the Vector. Needs a second
+ *                  buffer of N elements. Small Vectors are sorted in place on
+ *                  the calling thread, since threads would cost more than they
+ *                  save.
+ *   AUTO           Checks the priorities first. If they are all whole numbers
+ *                  in a range no wider than the Vector is long, or than 1024
+ *                  for shorter Vectors (years, levels, counts), they are sorted
+ *                  through a PQBucketQueue in O(N + range) with no
+ *                  comparisons; otherwise as for IN_PLACE_HEAP.
+ */
+enum class PQSortMode {
+    IN_PLACE_HEAP,
+    INTROSORT,
+    PARALLEL_MERGE,
+    AUTO
+};
+
 /**
  * Given a Vector of DataPoints, modify the vector to re-arrange the
- * elements into increasing order by priority.
+ * elements into increasing order by priority. The mode picks the strategy
+ * at runtime; see PQSortMode. numThreads is the number of worker threads
+ * PARALLEL_MERGE may use (at most 64), 0 meaning one per hardware thread; the
+ * other modes ignore it.
  *
  * The expected Big O runtime of pqSort is
  *   N*(O(enqueue) + O(dequeue)) where enqueue/dequeue for PQueue of size N
+ * With PARALLEL_MERGE and T threads this is O((N/T) log(N/T)) per thread plus
+ * an O(N log T) merge.
  */
-void pqSort(Vector<DataPoint>& v);
+void pqSort(Vector<DataPoint>& v, PQSortMode mode = PQSortMode::IN_PLACE_HEAP, int numThreads = 0);
 
 
 /**
@@ -39,3 +76,56 @@ void pqSort(Vector<DataPoint>& v);
  *         order of weight, where n is the number of items in the stream.
  */
 Vector<DataPoint> topK(std::istream& stream, int k);
+
+/**
+ * Same as topK above, but reads the DataPoints from a stream in the binary format
+ * (see datapointstream.h) rather than the text format. Decoding binary records is
+ * much cheaper than parsing text, so prefer this overload on large inputs.
+ *
+ * @param reader A reader positioned at the start of a binary DataPoint stream.
+ * @param k The number of elements to read.
+ * @return The min{n, k} data points of the stream with the highest weight, sorted in descending
+ *         order of weight, where n is the number of items in the stream.
+ */
+Vector<DataPoint> topK(DataPointReader& reader, int k);
+
+/**
+ * Same as topK above, but walks a memory-mapped DataPoint file (text or binary).
+ * While scanning, labels stay string_view slices of the mapping; only the labels
+ * of the final min{n, k} survivors are copied out into the returned DataPoints.
+ *
+ * @param reader A reader over a MappedDataPointFile, which must outlive the call.
+ * @param k The number of elements to read.
+ * @return The min{n, k} data points of the file with the highest weight, sorted in descending
+ *         order of weight, where n is the number of items in the file.
+ */
+Vector<DataPoint> topK(MappedDataPointReader& reader, int k);
+
+/**
+ * Parallel versions of topK. The input is split into one contiguous part per
+ * worker thread; each worker keeps its own BoundedTopK of its part's k best
+ * points, and the at most numThreads * k survivors are merged into the final
+ * result on the calling thread.
+ *
+ * Every topK variant ranks equal priorities by label (see PriorityThenLabelRank
+ * in boundedtopk.h), so the result is exactly what topK returns for the same
+ * points, whatever the thread count.
+ *
+ * For a file, the parts are byte ranges from splitDataPointFile. If a text file
+ * cannot be split cleanly (a part does not end where the next begins, or starts
+ * inside a record), the file is scanned on the calling thread instead. Splitting
+ * a binary file is a serial phase that reads every record's length prefix before
+ * any worker starts; a caller that ranks one file many times can split it once
+ * and pass the boundaries to the last overload, which takes one worker per range.
+ *
+ * @param v / file The DataPoints to rank; a file must outlive the call.
+ * @param k The number of elements to return.
+ * @param numThreads How many worker threads to use (at most 64), or 0 for one per hardware thread.
+ * @param boundaries Byte ranges of file from splitDataPointFile, at most 64 of them; otherwise this
+ *        function calls error().
+ * @return The min{n, k} data points with the highest weight, sorted in descending
+ *         order of weight, where n is the number of points in the input.
+ */
+Vector<DataPoint> parallelTopK(const Vector<DataPoint>& v, int k, int numThreads = 0);
+Vector<DataPoint> parallelTopK(const MappedDataPointFile& file, int k, int numThreads = 0);
+Vector<DataPoint> parallelTopK(const MappedDataPointFile& file, const std::vector<std::size_t>& boundaries, int k);
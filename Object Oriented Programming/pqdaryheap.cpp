@@ -0,0 +1,134 @@
+/*
+ * This file, pqdaryheap, holds the test cases for the PQDaryHeap class template defined in pqdaryheap.h,
+ * along with a time trial that compares the 4-ary and 8-ary heaps against the binary PQHeap.
+ */
+#include "pqdaryheap.h"
+#include "pqheap.h"
+#include "random.h"
+#include "testsupport.h"
+#include "SimpleTest.h"
+#include <functional>
+#include <memory>
+using namespace std;
+
+template class PQDaryHeap<4>;
+template class PQDaryHeap<8>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("PQDaryHeap: example from PQHeap writeup, 4-ary and 8-ary") {
+    Vector<DataPoint> input = {
+        {"R", 4}, {"A", 5}, {"B", 3}, {"K", 7}, {"G", 2},
+        {"V", 9}, {"T", 1}, {"O", 8}, {"S", 6} };
+
+    PQDaryHeap4 pq4;
+    PQDaryHeap8 pq8;
+    for (DataPoint dp : input) {
+        pq4.enqueue(dp);
+        pq8.enqueue(dp);
+        pq4.debugConfirmInternalArray();
+        pq8.debugConfirmInternalArray();
+    }
+    EXPECT_EQUAL(pq4.size(), input.size());
+    EXPECT_EQUAL(pq8.size(), input.size());
+
+    for (int priority = 1; priority <= 9; priority++) {
+        EXPECT_EQUAL(pq4.peek().priority, priority);
+        EXPECT_EQUAL(pq4.dequeue().priority, priority);
+        EXPECT_EQUAL(pq8.dequeue().priority, priority);
+        pq4.debugConfirmInternalArray();
+        pq8.debugConfirmInternalArray();
+    }
+    EXPECT(pq4.isEmpty());
+    EXPECT_ERROR(pq4.dequeue());
+    EXPECT_ERROR(pq8.peek());
+}
+
+STUDENT_TEST("PQDaryHeap: debugSetInternalArrayContents rejects a broken 4-ary heap") {
+    PQDaryHeap4 pq;
+
+    /* Index 0 has children 1-4; in a binary heap index 4 would be a grandchild. */
+    Vector<DataPoint> good = { {"a", 1}, {"b", 5}, {"c", 4}, {"d", 3}, {"e", 2}, {"f", 6} };
+    EXPECT_NO_ERROR(pq.debugSetInternalArrayContents(good, 6));
+    EXPECT_EQUAL(pq.debugGetInternalArrayContents(), good);
+
+    Vector<DataPoint> bad = { {"a", 1}, {"b", 5}, {"c", 4}, {"d", 3}, {"e", 2}, {"f", 4} };
+    EXPECT_ERROR(pq.debugSetInternalArrayContents(bad, 6));
+}
+
+STUDENT_TEST("PQDaryHeap: stress test against PQHeap, cycle random elements in and out") {
+    setRandomSeed(42);
+    PQHeap reference;
+    PQDaryHeap4 pq4;
+    PQDaryHeap8 pq8;
+
+    for (int i = 0; i < 5000; i++) {
+        if (randomChance(0.7) || reference.isEmpty()) {
+            DataPoint elem = {"", double(randomInteger(-100, 100))};
+            reference.enqueue(elem);
+            pq4.enqueue(elem);
+            pq8.enqueue(elem);
+        } else {
+            double expected = reference.dequeue().priority;
+            EXPECT_EQUAL(pq4.dequeue().priority, expected);
+            EXPECT_EQUAL(pq8.dequeue().priority, expected);
+        }
+        EXPECT_EQUAL(pq4.size(), reference.size());
+    }
+    pq4.debugConfirmInternalArray();
+    pq8.debugConfirmInternalArray();
+    pq4.clear();
+    EXPECT(pq4.isEmpty());
+}
+
+STUDENT_TEST("PQDaryHeap: move-only elements and custom comparator") {
+    PQDaryHeap<4, unique_ptr<int>, function<bool(const unique_ptr<int>&, const unique_ptr<int>&)>> pq(
+        [](const unique_ptr<int>& a, const unique_ptr<int>& b) { return *a > *b; });
+    for (int i = 0; i < 50; i++) {
+        pq.enqueue(make_unique<int>((i * 7) % 50));
+    }
+    for (int i = 49; i >= 0; i--) {
+        unique_ptr<int> front = pq.dequeue();
+        EXPECT_EQUAL(*front, i);
+    }
+}
+
+/* Each queue sees the same input. The DataPoint runs carry the std::string payload;
+ * the bare double runs show the layout effect when a whole sibling group fits in one line.
+ */
+STUDENT_TEST("PQDaryHeap: time binary vs 4-ary vs 8-ary heap at 10^5, 10^6, 10^7") {
+    for (int n = 100000; n <= 10000000; n *= 10) {
+        Vector<double> priorities;
+        for (int i = 0; i < n; i++) {
+            priorities.add(randomReal(0, 10));
+        }
+        {
+            Vector<DataPoint> points;
+            for (double p : priorities) {
+                points.add({"", p});
+            }
+            /* Each heap is freed before the next is filled, so only one is resident next to points. */
+            {
+                PQHeap binary;
+                TIME_OPERATION(n, fillThenDrain(binary, points));
+            }
+            {
+                PQDaryHeap4 fourAry;
+                TIME_OPERATION(n, fillThenDrain(fourAry, points));
+            }
+            {
+                PQDaryHeap8 eightAry;
+                TIME_OPERATION(n, fillThenDrain(eightAry, points));
+            }
+        }
+        {
+            BasicPQHeap<double, less<double>> binary;
+            PQDaryHeap<4, double, less<double>> fourAry;
+            PQDaryHeap<8, double, less<double>> eightAry;
+            TIME_OPERATION(n, fillThenDrain(binary, priorities));
+            TIME_OPERATION(n, fillThenDrain(fourAry, priorities));
+            TIME_OPERATION(n, fillThenDrain(eightAry, priorities));
+        }
+    }
+}
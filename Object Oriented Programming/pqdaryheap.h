@@ -0,0 +1,445 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include "strlib.h"
+#include "vector.h"
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Priority queue implemented using a d-ary heap, where every node has up to
+ * Arity children instead of two. The public interface is the same as
+ * BasicPQHeap's, so the two can be swapped for one another freely.
+ *
+ * A wider heap is shallower (log base Arity of n levels instead of log base 2),
+ * so a percolation touches fewer, more widely spaced parts of the array. To make
+ * each of those touches cheap, the array is offset so that the Arity children of
+ * any node are contiguous and begin on a cache-line boundary: with small
+ * elements such as doubles, all 4 or 8 children of a node are compared using a
+ * single cache line, and larger elements span the fewest lines possible.
+ *
+ * PQDaryHeap4 and PQDaryHeap8 (declared below the class) are the DataPoint
+ * versions used by the rest of the project.
+ */
+template <int Arity, typename T = DataPoint, typename Compare = LowerPriorityFirst>
+class PQDaryHeap {
+    static_assert(Arity >= 2, "A d-ary heap needs at least two children per node");
+
+public:
+    /**
+     * Creates a new, empty priority queue that orders elements using compare.
+     */
+    explicit PQDaryHeap(Compare compare = Compare());
+
+    /**
+     * Cleans up all memory allocated by this priority queue.
+     */
+    ~PQDaryHeap();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time O(log n),
+     * where n is the number of elements in the queue.
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Constructs a new element from args and adds it to the queue, just like
+     * BasicPQHeap::emplace.
+     *
+     * This operation runs in time O(log n).
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Removes and returns the element that is frontmost in this priority queue.
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(Arity * log n / log Arity).
+     *
+     * @return The frontmost element, which is moved out of the queue.
+     */
+    T dequeue();
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @return A reference to the frontmost element, valid until the queue is next modified.
+     */
+    const T& peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     *
+     * This operation runs in time O(1).
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     *
+     * This operation runs in time O(1).
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue.
+     *
+     * This operation runs in time O(n), since every element is destroyed.
+     */
+    void clear();
+
+    /*
+     * Debug functions with the same contract as BasicPQHeap's.
+     */
+
+    /*
+     * Confirms validity of internal array. Raises an error if a problem is found.
+     */
+    void debugConfirmInternalArray() const;
+
+    /*
+     * Return a Vector copy of the elements from the internal array.
+     */
+    Vector<T> debugGetInternalArrayContents() const;
+
+    /*
+     * Allocate the internal array to requested capacity and copy the elements
+     * from vector v into the internal array. The new contents of the internal
+     * array are confirmed by a call to debugConfirmInternalArray.
+     */
+    void debugSetInternalArrayContents(const Vector<T>& v, int capacity);
+
+private:
+    static const int INITIAL_CAPACITY = 16;     // starting number of allocated slots
+    static const int NONE = -1;                 // used as sentinel index
+    static const int CACHE_LINE_BYTES = 64;     // alignment of the storage block
+
+    /*
+     * The storage block holds Arity - 1 unused padding slots followed by the
+     * heap itself, so _elements = _storage + Arity - 1. The children of heap
+     * index i are at heap indexes Arity*i + 1 ... Arity*i + Arity, which are
+     * block slots Arity*(i+1) ... Arity*(i+1) + Arity - 1: a run that starts
+     * at a multiple of Arity. Because the block itself is cache-line aligned,
+     * every group of siblings starts at the same offset within its lines.
+     *
+     * Only the first _numFilled heap slots hold constructed elements; the rest
+     * of the block is raw memory.
+     */
+    T* _storage;            // cache-line aligned block, including the padding slots
+    T* _elements;           // first heap slot, Arity - 1 slots into _storage
+    int _numAllocated;      // number of heap slots allocated (padding not included)
+    int _numFilled;         // number of heap slots filled
+    Compare _compare;       // compare(a, b) is true when a is more urgent than b
+
+    static T* allocateStorage(int capacity);
+    static void releaseStorage(T* storage);
+
+    void expandAllocation(); // doubles the number of allocated heap slots
+    void validateIndex(int index) const;
+    void place(T&& element); // appends element and percolates it up
+    void percolateUp(int hole, T&& element);
+    void percolateDown(int hole, T&& element);
+
+    int getParentIndex(int child) const;
+    int getFirstChildIndex(int parent) const;
+
+    DISALLOW_COPYING_OF(PQDaryHeap);
+};
+
+/**
+ * Priority queues of DataPoints implemented using 4-ary and 8-ary heaps.
+ */
+using PQDaryHeap4 = PQDaryHeap<4>;
+using PQDaryHeap8 = PQDaryHeap<8>;
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+/*
+ * The constructor allocates an aligned block for the initial capacity and
+ * stores the comparator. No elements are constructed until they are enqueued.
+ */
+template <int Arity, typename T, typename Compare>
+PQDaryHeap<Arity, T, Compare>::PQDaryHeap(Compare compare) : _compare(std::move(compare)) {
+    _numAllocated = INITIAL_CAPACITY;
+    _storage = allocateStorage(_numAllocated);
+    _elements = _storage + (Arity - 1);
+    _numFilled = 0;
+}
+
+/*
+ * The destructor destroys the live elements and then frees the block.
+ */
+template <int Arity, typename T, typename Compare>
+PQDaryHeap<Arity, T, Compare>::~PQDaryHeap() {
+    clear();
+    releaseStorage(_storage);
+}
+
+/*
+ * Allocates raw, cache-line aligned memory for capacity heap slots plus the
+ * Arity - 1 padding slots in front of them.
+ */
+template <int Arity, typename T, typename Compare>
+T* PQDaryHeap<Arity, T, Compare>::allocateStorage(int capacity) {
+    size_t bytes = sizeof(T) * (size_t(capacity) + Arity - 1);
+    size_t alignment = std::max<size_t>(CACHE_LINE_BYTES, alignof(T));
+    return static_cast<T*>(::operator new(bytes, std::align_val_t(alignment)));
+}
+
+/*
+ * Frees a block from allocateStorage. Any elements in it must already be destroyed.
+ */
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::releaseStorage(T* storage) {
+    size_t alignment = std::max<size_t>(CACHE_LINE_BYTES, alignof(T));
+    ::operator delete(storage, std::align_val_t(alignment));
+}
+
+/*
+ * Doubles the capacity, moving every live element into the new block and
+ * destroying the moved-from originals.
+ */
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::expandAllocation() {
+    int newAllocated = _numAllocated * 2;
+    T* newStorage = allocateStorage(newAllocated);
+    T* newElements = newStorage + (Arity - 1);
+
+    for (int i = 0; i < _numFilled; i++) {
+        new (newElements + i) T(std::move(_elements[i]));
+        _elements[i].~T();
+    }
+    releaseStorage(_storage);
+
+    _storage = newStorage;
+    _elements = newElements;
+    _numAllocated = newAllocated;
+}
+
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::enqueue(const T& element) {
+    place(T(element));
+}
+
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::enqueue(T&& element) {
+    place(std::move(element));
+}
+
+template <int Arity, typename T, typename Compare>
+template <typename... Args>
+void PQDaryHeap<Arity, T, Compare>::emplace(Args&&... args) {
+    if constexpr (std::is_constructible<T, Args&&...>::value) {
+        place(T(std::forward<Args>(args)...));
+    } else {
+        place(T{std::forward<Args>(args)...});
+    }
+}
+
+/*
+ * Moves element into a newly constructed slot at the end of the heap, then
+ * percolates it up from there.
+ */
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::place(T&& element) {
+    if (_numFilled == _numAllocated) {
+        expandAllocation();
+    }
+
+    // The new slot must hold a constructed object before the percolation can
+    // move-assign into it; the parent it is compared against is left alone.
+    int hole = _numFilled;
+    int parentIdx = getParentIndex(hole);
+    if (parentIdx == NONE || !_compare(element, _elements[parentIdx])) {
+        new (_elements + hole) T(std::move(element));
+        _numFilled++;
+        return;
+    }
+    new (_elements + hole) T(std::move(_elements[parentIdx]));
+    _numFilled++;
+    percolateUp(parentIdx, std::move(element));
+}
+
+template <int Arity, typename T, typename Compare>
+const T& PQDaryHeap<Arity, T, Compare>::peek() const {
+    if (isEmpty()) {
+        error("Cannot peek because PQDaryHeap is empty!");
+    }
+    return _elements[0];
+}
+
+/*
+ * Moves the root out, then re-seats the former last element starting from the
+ * hole left at the root. The vacated last slot is destroyed.
+ */
+template <int Arity, typename T, typename Compare>
+T PQDaryHeap<Arity, T, Compare>::dequeue() {
+    if (isEmpty()) {
+        error("Cannot dequeue because PQDaryHeap is empty!");
+    }
+
+    T front = std::move(_elements[0]);
+    int lastIdx = _numFilled - 1;
+    if (lastIdx > 0) {
+        T last = std::move(_elements[lastIdx]);
+        _elements[lastIdx].~T();
+        _numFilled--;
+        percolateDown(0, std::move(last));
+    } else {
+        _elements[0].~T();
+        _numFilled--;
+    }
+    return front;
+}
+
+template <int Arity, typename T, typename Compare>
+bool PQDaryHeap<Arity, T, Compare>::isEmpty() const {
+    return size() == 0;
+}
+
+template <int Arity, typename T, typename Compare>
+int PQDaryHeap<Arity, T, Compare>::size() const {
+    return _numFilled;
+}
+
+/*
+ * Destroys every live element. The block stays allocated at its current capacity.
+ */
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::clear() {
+    for (int i = 0; i < _numFilled; i++) {
+        _elements[i].~T();
+    }
+    _numFilled = 0;
+}
+
+template <int Arity, typename T, typename Compare>
+int PQDaryHeap<Arity, T, Compare>::getParentIndex(int child) const {
+    if (child <= 0) {
+        return NONE;
+    }
+    return (child - 1) / Arity;
+}
+
+/*
+ * Returns the heap index of the first of parent's (up to Arity) children, or
+ * NONE if parent is a leaf. The remaining children follow it contiguously.
+ */
+template <int Arity, typename T, typename Compare>
+int PQDaryHeap<Arity, T, Compare>::getFirstChildIndex(int parent) const {
+    if (parent < 0) {
+        return NONE;
+    }
+    int firstChildIndex = Arity * parent + 1;
+    if (firstChildIndex >= _numFilled) {
+        return NONE;
+    }
+    return firstChildIndex;
+}
+
+/*
+ * Treats index hole as empty and shifts less urgent parents down into it until
+ * element fits, then writes element into the final hole.
+ */
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::percolateUp(int hole, T&& element) {
+    validateIndex(hole);
+
+    int parentIdx = getParentIndex(hole);
+    while (parentIdx != NONE && _compare(element, _elements[parentIdx])) {
+        _elements[hole] = std::move(_elements[parentIdx]);
+        hole = parentIdx;
+        parentIdx = getParentIndex(hole);
+    }
+    _elements[hole] = std::move(element);
+}
+
+/*
+ * Treats index hole as empty and pulls the most urgent of its children up into
+ * it for as long as that child is more urgent than element, then writes
+ * element into the final hole. The scan over the children reads one
+ * contiguous, aligned run of the array.
+ */
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::percolateDown(int hole, T&& element) {
+    validateIndex(hole);
+
+    while (true) {
+        int firstIdx = getFirstChildIndex(hole);
+        if (firstIdx == NONE) {
+            break;
+        }
+
+        int endIdx = std::min(firstIdx + Arity, _numFilled);
+        int bestIdx = firstIdx;
+        for (int i = firstIdx + 1; i < endIdx; i++) {
+            if (_compare(_elements[i], _elements[bestIdx])) {
+                bestIdx = i;
+            }
+        }
+
+        if (!_compare(_elements[bestIdx], element)) {
+            break;
+        }
+        _elements[hole] = std::move(_elements[bestIdx]);
+        hole = bestIdx;
+    }
+    _elements[hole] = std::move(element);
+}
+
+/*
+ * Checks that no element is more urgent than its parent.
+ */
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::debugConfirmInternalArray() const {
+    if (_numFilled > _numAllocated) error("Too many elements in not enough space!");
+
+    for (int i = _numFilled - 1; i > 0; i--) {
+        if (_compare(_elements[i], _elements[getParentIndex(i)])) {
+            error("PQDaryHeap index: " + integerToString(i) + " is out of order with its parent!");
+        }
+    }
+}
+
+template <int Arity, typename T, typename Compare>
+Vector<T> PQDaryHeap<Arity, T, Compare>::debugGetInternalArrayContents() const {
+    Vector<T> v;
+    for (int i = 0; i < size(); i++) {
+        v.add(_elements[i]);
+    }
+    return v;
+}
+
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::debugSetInternalArrayContents(const Vector<T>& v, int capacity) {
+    if (v.size() > capacity || capacity == 0) {
+        error("Invalid capacity for debugSetInternalArrayContents!");
+    }
+    clear();                                // destroy old contents
+    releaseStorage(_storage);               // discard old memory
+    _storage = allocateStorage(capacity);   // allocate new memory
+    _elements = _storage + (Arity - 1);
+    _numAllocated = capacity;
+    for (int i = 0; i < v.size(); i++) {    // fill contents with copy from vector
+        new (_elements + i) T(v[i]);
+        _numFilled++;
+    }
+    debugConfirmInternalArray();            // confirm contents valid
+}
+
+template <int Arity, typename T, typename Compare>
+void PQDaryHeap<Arity, T, Compare>::validateIndex(int index) const {
+    if (index < 0 || index >= _numFilled) error("Invalid index " + integerToString(index));
+}
@@ -1,6 +1,7 @@
 /* Author: Theo Snoey
- * This file, PQHeap, uses the PQHeap class, define in PQHeap.h and implements the methods fro that class
- * to create a coherent working PQHeap Class that can be referred to to solve ranking and sorting problems efficiently.
+ * This file, PQHeap, holds the test cases for the BasicPQHeap class template defined in pqheap.h. The member
+ * functions themselves live in the header because BasicPQHeap is a template; the explicit instantiation below
+ * makes sure the DataPoint version (PQHeap) used to solve ranking and sorting problems always compiles in full.
  */
 #include "pqheap.h"
 #include "error.h"
@@ -8,288 +9,13 @@
 #include "strlib.h"
 #include "datapoint.h"
 #include "SimpleTest.h"
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
 using namespace std;
 
-const int INITIAL_CAPACITY = 10;    // program-wide constant
-const int NONE = -1;                // used as sentinel index
-
-/*
- * This constructor initializes the PQHeap object and assigns _numalloactd to the initial capacity,
- * creates the array of datapoints, _elements, and sets numFilled = 0;
- */
-PQHeap::PQHeap() {
-    _numAllocated = INITIAL_CAPACITY;
-    _elements = new DataPoint[_numAllocated];
-    _numFilled = 0;
-}
-
-/*
- * This destructor, deletes the elements array to avoid any memory allocation issues
- */
-PQHeap::~PQHeap() {
-    delete[] _elements;
-}
-
-// this function, expandAllocation, doubles the allocated capacity of our heap. It is
-// typically called when the numfilled = _numAllocated
-void PQHeap::expandAllocation(){
-
-    _numAllocated = _numAllocated * 2;
-
-    DataPoint *newArray = new DataPoint[_numAllocated];
-    for (int i = 0; i < size(); i++){
-        newArray[i] = _elements[i];
-    }
-
-    delete[] _elements;
-
-    _elements = newArray;
-}
-
-
-
-/*
- * This method, enqueue, takes a dataPoint element, elem, and adds it to the end of the
- * array, then percolates up comparing each spot to its parent's priority to properly assign it to the queue.
- */
-void PQHeap::enqueue(DataPoint elem) {
-
-    if (size() == _numAllocated){
-        expandAllocation();
-    }
-
-    _elements[size()] = elem;
-    _numFilled ++;
-
-    int thisIdx = size() - 1;
-    validateIndex(thisIdx);
-
-    while (thisIdx > 0 && _elements[getParentIndex(thisIdx)].priority > _elements[thisIdx].priority){
-        swapElements(thisIdx, getParentIndex(thisIdx));
-        thisIdx = getParentIndex(thisIdx);
-    }
-
-}
-
-/*
- * This method, peek(), returns the first element in the queue (without dequeueing it).
- */
-DataPoint PQHeap::peek() const {
-    if (isEmpty()){
-        error("Cannot peek because PQHeap is empty!");
-    }
-    return _elements[0];
-}
-
-/*
- * This method, dequeue, removes the highest priority item (lowest priority score) from the queue, returning it, and replacing that
- * spot with the lowest priority element, then calls percolateDown to percolate that lowest element down comparing it to its children
- * to find the proper priority spot
- */
-DataPoint PQHeap::dequeue() {
-    int lastIdx = size() - 1;
-    int firstIdx = 0;
-
-    DataPoint deQueuedData = peek();
-
-    validateIndex(lastIdx);
-    validateIndex(firstIdx);
-
-    swapElements(lastIdx, firstIdx);
-
-    // delete first data point in now last position
-    _numFilled --;
-
-    percolateDown();
-
-    return deQueuedData;
-}
-
-/*
- * This method, isEmpty, returns true if the array/queue is empty, false otherwise
- */
-bool PQHeap::isEmpty() const {
-    if (size() == 0){
-        return true;
-    }
-    return false;
-}
-
-/*
- * This method, size, returns the number of filled spots in the queue
- */
-int PQHeap::size() const {
-    // return the number of filled spots
-    return _numFilled;
-}
-
-/*
- * this method, sets the number of filled spots in the queue/heap/array to be zero
- */
-void PQHeap::clear() {
-    // set the number of filled spots to zero
-    _numFilled = 0;
-}
-
-/*
- * We strongly recommend implementing this helper function, which
- * calculates the index of the element that is the parent of the
- * specified child index. If this child has no parent, return
- * the sentinel value NONE.
- */
-int PQHeap::getParentIndex(int child) const {
-    if (child < 0){
-        return NONE;
-    }
-    int parentIndex = (child - 1) / 2;
-    return parentIndex;
-}
-
-/*
- * We strongly recommend implementing this helper function, which
- * calculates the index of the element that is the left child of the
- * specified parent index. If this parent has no left child, return
- * the sentinel value NONE.
- */
-int PQHeap::getLeftChildIndex(int parent) const {
-
-    if (parent < 0){
-        return NONE;
-    }
-
-    int leftChildIndex = (2 * parent) + 1;
-
-    if (leftChildIndex >= _numFilled){
-        return NONE;
-    }
-
-    return leftChildIndex;
-}
-
-/*
- * We strongly recommend implementing this helper function, which
- * calculates the index of the element that is the right child of the
- * specified parent index. If this parent has no right child, return
- * the sentinel value NONE.
- */
-int PQHeap::getRightChildIndex(int parent) const {
-
-    if (parent < 0){
-        return NONE;
-    }
-
-    int rightChildIndex = (2 * parent) + 2;
-
-    if (rightChildIndex >= _numFilled){
-        return NONE;
-    }
-
-    return rightChildIndex;
-}
-
-/*
- * We strongly recommend implementing this helper function that swaps
- * array elements. There is a swapElements member function implemented
- * in PQAarray that you start from. Be sure to include error bounds-checking
- * it is an invaluable defense against indexing mistakes!
- */
-void PQHeap::swapElements(int indexA, int indexB) {
-    validateIndex(indexA);
-    validateIndex(indexB);
-    DataPoint tmp = _elements[indexA];
-    _elements[indexA] = _elements[indexB];
-    _elements[indexB] = tmp;
-}
-
-/*
- * To confirm the validity of the internal array, you must check that
- * the heap property holds for all elements in the array. If elements are
- * found that violate the heap property, report an error.
- */
-void PQHeap::debugConfirmInternalArray() const {
-
-    if (_numFilled > _numAllocated) error("Too many elements in not enough space!");
-
-    for (int i = _numFilled - 1; i > 0; i --){
-        if (_elements[i].priority < _elements[getParentIndex(i)].priority){
-            error("PQHeap index: " + integerToString(i) + ", priority: " + integerToString(_elements[i].priority) + " is out of order!");
-        }
-    }
-}
-
-// This method, debugGetInternalArrayContents, serves as a helper for debugging by creating a vector copy
-// of the elements in the queue, returning it.
-Vector<DataPoint> PQHeap::debugGetInternalArrayContents() const {
-    Vector<DataPoint> v;
-
-    for (int i = 0; i < size(); i++) {
-        v.add(_elements[i]);
-    }
-    return v;
-}
-
-// This method, debugSdtInternalArrayContents, takes a vecotor of DataPoints and a capacity
-// and creates a new element data point queue inputting vector elements into that queue and returning it.
-void PQHeap::debugSetInternalArrayContents(const Vector<DataPoint>& v, int capacity) {
-    if (v.size() > capacity || capacity == 0) {
-        error("Invalid capacity for debugSetInternalArrayContents!");
-    }
-    delete[] _elements;                     // discard old memory
-    _elements = new DataPoint[capacity];    // allocate new memory
-    _numAllocated = capacity;
-    _numFilled = v.size();
-    for (int i = 0; i < v.size(); i++) {    // fill contents with copy from vector
-        _elements[i] = v[i];
-    }
-    debugConfirmInternalArray();            // confirm contents valid
-}
-
-// This method, validate index, takes an index and raises an error if that index is invalid/out of bounds.
-void PQHeap::validateIndex(int index) const {
-    if (index < 0 || index >= _numFilled) error("Invalid index " + integerToString(index));
-}
-
-// this helper method, percolataeDown starts from the first index/ top stop of the heap
-// and performs the percolate down process comparing an element to its children to find the proper
-// priority spot.
-void PQHeap::percolateDown(){
-    int thisIdx = 0;
-
-    while (thisIdx <= (size() / 2)){
-        int rcIdx = getRightChildIndex(thisIdx);
-        int lcIdx = getLeftChildIndex(thisIdx);
-        int smallestOfChildren;
-
-        // find smaller of both children
-
-        if (lcIdx == -1 && lcIdx == -1){
-            break;
-        }
-
-        if (lcIdx != -1 && ((_elements[lcIdx].priority < _elements[rcIdx].priority) || rcIdx == -1)){
-            smallestOfChildren = lcIdx;
-        }
-
-        if (rcIdx != -1 && ((_elements[rcIdx].priority < _elements[lcIdx].priority) || lcIdx == -1)){
-            smallestOfChildren = rcIdx;
-        }
-
-        // compare smallest child to current priority
-
-        if (_elements[smallestOfChildren].priority >= _elements[thisIdx].priority){
-            break;
-        }
-
-        // if we found a smaller index = keep going
-
-        else {
-            swapElements(thisIdx, smallestOfChildren);
-            thisIdx = smallestOfChildren;
-        }
-
-    }
-
-}
+template class BasicPQHeap<DataPoint>;
 
 
 /* * * * * * Test Cases Below This Point * * * * * */
@@ -338,7 +64,8 @@ STUDENT_TEST("PQHeap, testing enqueue / dequeue with diff vals") {
 
     EXPECT_EQUAL(pq.size(), 6);
 
-    EXPECT_EQUAL(pq.peek(), pq.dequeue());
+    DataPoint front = pq.peek(); // peek returns a reference, so copy it before dequeue moves it out
+    EXPECT_EQUAL(front, pq.dequeue());
     pq.debugConfirmInternalArray();
 
     pq.dequeue();
@@ -387,6 +114,181 @@ STUDENT_TEST("PQHeap: stress test, cycle random elements in and out") {
     EXPECT_EQUAL(sumEnqueued, sumDequeued);
 }
 
+/* A move-only element type: the unique_ptr makes any accidental copy a compile error. */
+struct MoveOnlyJob {
+    unique_ptr<string> label;
+    double priority;
+};
+
+STUDENT_TEST("BasicPQHeap: move-only elements are moved in and out, never copied") {
+    BasicPQHeap<MoveOnlyJob> pq;
+    Vector<double> priorities = { 4, 5, 3, 7, 2, 9, 1, 8, 6, 0, 11, 10 };
+
+    for (double p : priorities) {
+        pq.enqueue({ make_unique<string>("job " + realToString(p)), p });
+        pq.debugConfirmInternalArray();
+    }
+    EXPECT_EQUAL(pq.size(), priorities.size());
+    EXPECT_EQUAL(*pq.peek().label, "job 0");
+
+    for (int i = 0; i < priorities.size(); i++) {
+        MoveOnlyJob job = pq.dequeue();
+        EXPECT_EQUAL(job.priority, i);
+        EXPECT_EQUAL(*job.label, "job " + realToString(i));
+        pq.debugConfirmInternalArray();
+    }
+    EXPECT(pq.isEmpty());
+}
+
+/* Counts live elements and default constructions, to show which slots of the array hold real objects. */
+struct CountedJob {
+    CountedJob() : priority(0) { live++; defaultConstructed++; }
+    CountedJob(double p) : priority(p) { live++; }
+    CountedJob(const CountedJob& other) : priority(other.priority) { live++; }
+    CountedJob(CountedJob&& other) : priority(other.priority) { live++; }
+    CountedJob& operator=(const CountedJob& other) = default;
+    CountedJob& operator=(CountedJob&& other) = default;
+    ~CountedJob() { live--; }
+
+    double priority;
+    static int live;
+    static int defaultConstructed;
+};
+int CountedJob::live = 0;
+int CountedJob::defaultConstructed = 0;
+
+STUDENT_TEST("BasicPQHeap: slots past the last element are never constructed") {
+    CountedJob::live = CountedJob::defaultConstructed = 0;
+    {
+        BasicPQHeap<CountedJob> pq;
+        for (int i = 0; i < 1000; i++) {
+            pq.enqueue(CountedJob((i * 7919) % 1000));
+        }
+        EXPECT_EQUAL(CountedJob::live, 1000);
+        EXPECT_EQUAL(CountedJob::defaultConstructed, 0);       // new slots are move-constructed, growth too
+        EXPECT(pq.capacity() >= 1000);
+
+        for (int i = 0; i < 400; i++) {
+            EXPECT_EQUAL(pq.dequeue().priority, i);
+        }
+        EXPECT_EQUAL(CountedJob::live, 600);
+
+        pq.shrinkToFit();
+        EXPECT_EQUAL(pq.capacity(), 600);
+        EXPECT_EQUAL(CountedJob::live, 600);
+        EXPECT_EQUAL(pq.peek().priority, 400);
+
+        pq.clear();
+        EXPECT_EQUAL(CountedJob::live, 0);
+        pq.enqueue(CountedJob(1));
+    }
+    EXPECT_EQUAL(CountedJob::live, 0);
+}
+
+/* Has no default constructor, so the heap can only ever move-construct it into a slot. */
+struct PricedJob {
+    explicit PricedJob(double p) : priority(p) {}
+    double priority;
+};
+
+STUDENT_TEST("BasicPQHeap: element types without a default constructor work") {
+    BasicPQHeap<PricedJob> pq;
+    for (int i = 0; i < 100; i++) {
+        pq.enqueue(PricedJob((i * 37) % 100));
+    }
+    pq.debugConfirmInternalArray();
+    vector<PricedJob> batch;
+    for (int i = 100; i < 300; i++) {
+        batch.push_back(PricedJob(i));
+    }
+    pq.enqueueAll(std::move(batch));        // larger than the heap: appended and re-heapified
+    pq.enqueueAll(vector<PricedJob>{ PricedJob(-1) });
+    EXPECT_EQUAL(pq.replaceTop(PricedJob(300)).priority, -1);
+
+    for (int i = 0; i < 301; i++) {
+        EXPECT_EQUAL(pq.dequeue().priority, i);
+    }
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("PQHeap: reserve, shrinkToFit and growth factor control the capacity") {
+    PQHeap pq;
+    EXPECT_EQUAL(pq.capacity(), 10);
+    pq.reserve(1000);
+    EXPECT_EQUAL(pq.capacity(), 1000);
+    pq.reserve(5);
+    EXPECT_EQUAL(pq.capacity(), 1000);
+    EXPECT_ERROR(pq.reserve(-1));
+
+    for (int i = 1000; i > 0; i--) {
+        pq.enqueue({"", double(i)});
+    }
+    EXPECT_EQUAL(pq.capacity(), 1000);
+    pq.enqueue({"", 0});
+    EXPECT_EQUAL(pq.capacity(), 2000);
+
+    for (int i = 0; i < 900; i++) {
+        EXPECT_EQUAL(pq.dequeue().priority, i);
+    }
+    pq.shrinkToFit();
+    EXPECT_EQUAL(pq.capacity(), 101);
+    pq.debugConfirmInternalArray();
+    EXPECT_EQUAL(pq.peek().priority, 900);
+
+    pq.clear();
+    pq.shrinkToFit();
+    EXPECT_EQUAL(pq.capacity(), 0);
+    pq.enqueue({"after", 1});                                   // grows from nothing
+    EXPECT_EQUAL(pq.dequeue(), {"after", 1});
+
+    PQHeap slow;
+    slow.setGrowthFactor(1.5);
+    for (int i = 0; i < 11; i++) {
+        slow.enqueue({"", double(i)});
+    }
+    EXPECT_EQUAL(slow.capacity(), 15);
+    EXPECT_ERROR(slow.setGrowthFactor(1));
+    EXPECT_ERROR(slow.setGrowthFactor(nan("")));
+}
+
+STUDENT_TEST("BasicPQHeap: emplace builds elements from their constructor arguments") {
+    PQHeap pq;
+    pq.emplace("B", 2.0);
+    pq.emplace("A", 1.0);
+    pq.emplace(DataPoint{"C", 3});
+    pq.debugConfirmInternalArray();
+
+    EXPECT_EQUAL(pq.dequeue(), {"A", 1});
+    EXPECT_EQUAL(pq.dequeue(), {"B", 2});
+    EXPECT_EQUAL(pq.dequeue(), {"C", 3});
+    EXPECT_ERROR(pq.dequeue());
+}
+
+STUDENT_TEST("BasicPQHeap: custom comparator turns it into a max-heap") {
+    BasicPQHeap<int, greater<int>> pq;
+    for (int i = 0; i < 100; i++) {
+        pq.enqueue((i * 37) % 100);
+    }
+    pq.debugConfirmInternalArray();
+    for (int i = 99; i >= 0; i--) {
+        EXPECT_EQUAL(pq.dequeue(), i);
+    }
+}
+
+STUDENT_TEST("PQHeap: replaceTop swaps the front element with one percolate-down") {
+    PQHeap pq;
+    EXPECT_ERROR(pq.replaceTop({"X", 0}));
+    for (int i = 1; i <= 7; i++) {
+        pq.enqueue({"", double(i)});
+    }
+    EXPECT_EQUAL(pq.replaceTop({"big", 10}).priority, 1);
+    pq.debugConfirmInternalArray();
+    EXPECT_EQUAL(pq.replaceTop({"small", 0}).priority, 2);
+    pq.debugConfirmInternalArray();
+    EXPECT_EQUAL(pq.dequeue().label, "small");
+    EXPECT_EQUAL(pq.size(), 6);
+}
+
 void fillQueue(PQHeap& pq, int n) {
     pq.clear(); // start with empty queue
     for (int i = 0; i < n; i++) {
@@ -408,3 +310,183 @@ PROVIDED_TEST("PQArray: time fillQueue and emptyQueue") {
     EXPECT_EQUAL(pq.size(), n);
     TIME_OPERATION(n, emptyQueue(pq, n));
 }
+
+STUDENT_TEST("PQHeap: time fillQueue and emptyQueue at 10^6 to 10^7 elements") {
+    for (int n = 1000000; n <= 10000000; n *= 10) {
+        PQHeap pq;
+        TIME_OPERATION(n, fillQueue(pq, n));
+        EXPECT_EQUAL(pq.size(), n);
+        TIME_OPERATION(n, emptyQueue(pq, n));
+        EXPECT(pq.isEmpty());
+    }
+}
+
+STUDENT_TEST("PQHeap: buildFrom heapifies a whole vector and leaves it empty") {
+    Vector<DataPoint> input = {
+        {"R", 4}, {"A", 5}, {"B", 3}, {"K", 7}, {"G", 2},
+        {"V", 9}, {"T", 1}, {"O", 8}, {"S", 6} };
+    PQHeap pq;
+    pq.enqueue({"stale", -1});
+
+    pq.buildFrom(std::move(input));
+    EXPECT(input.isEmpty());
+    EXPECT_EQUAL(pq.size(), 9);
+    pq.debugConfirmInternalArray();
+    for (int priority = 1; priority <= 9; priority++) {
+        EXPECT_EQUAL(pq.dequeue().priority, priority);
+    }
+
+    Vector<DataPoint> empty;
+    pq.buildFrom(std::move(empty));
+    EXPECT(pq.isEmpty());
+    pq.enqueue({"after", 1});
+    EXPECT_EQUAL(pq.peek().label, "after");
+}
+
+STUDENT_TEST("PQHeap: buildFrom matches repeated enqueue on random input") {
+    setRandomSeed(7);
+    for (int n = 1; n < 300; n += 37) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"", double(randomInteger(0, 50))});
+        }
+        PQHeap built, enqueued;
+        for (const DataPoint& dp : input) {
+            enqueued.enqueue(dp);
+        }
+        built.buildFrom(std::move(input));
+        built.debugConfirmInternalArray();
+        while (!enqueued.isEmpty()) {
+            EXPECT_EQUAL(built.dequeue().priority, enqueued.dequeue().priority);
+        }
+        EXPECT(built.isEmpty());
+    }
+}
+
+void enqueueEach(PQHeap& pq, Vector<DataPoint>& input) {
+    for (int i = 0; i < input.size(); i++) {
+        pq.enqueue(std::move(input[i]));
+    }
+}
+
+STUDENT_TEST("PQHeap: time buildFrom against one enqueue per element") {
+    for (int n = 1000000; n <= 10000000; n *= 10) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"", randomReal(0, 10)});
+        }
+        Vector<DataPoint> copy = input;
+
+        PQHeap enqueued, built;
+        TIME_OPERATION(n, enqueueEach(enqueued, input));
+        TIME_OPERATION(n, built.buildFrom(std::move(copy)));
+        EXPECT_EQUAL(built.size(), n);
+    }
+}
+
+STUDENT_TEST("PQHeap: enqueueAll percolates small batches, re-heapifies large ones, dequeueMany drains in order") {
+    PQHeap pq;
+    Vector<DataPoint> first = { {"e", 5}, {"b", 2}, {"h", 8}, {"a", 1} };
+    pq.enqueueAll(first);                                   // into an empty heap: re-heapified
+    EXPECT_EQUAL(first.size(), 4);
+    pq.debugConfirmInternalArray();
+
+    Vector<DataPoint> second = { {"c", 3} };
+    pq.enqueueAll(std::move(second));                       // smaller than the heap: percolated
+    pq.debugConfirmInternalArray();
+    EXPECT_EQUAL(pq.size(), 5);
+
+    DataPoint out[3];
+    EXPECT(pq.dequeueMany(3, out) == out + 3);
+    EXPECT_EQUAL(out[0], {"a", 1});
+    EXPECT_EQUAL(out[1], {"b", 2});
+    EXPECT_EQUAL(out[2], {"c", 3});
+    pq.debugConfirmInternalArray();
+    EXPECT_ERROR(pq.dequeueMany(3, out));
+    EXPECT_ERROR(pq.dequeueMany(-1, out));
+
+    vector<DataPoint> rest;
+    pq.dequeueMany(2, back_inserter(rest));
+    EXPECT_EQUAL(rest, { {"e", 5}, {"h", 8} });
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("PQHeap: enqueueAll and dequeueMany match single operations on random batches") {
+    setRandomSeed(17);
+    PQHeap batched, single;
+    for (int round = 0; round < 40; round++) {
+        Vector<DataPoint> batch;
+        for (int i = randomInteger(0, 2 * batched.size() + 5); i > 0; i--) {
+            batch.add({"", double(randomInteger(0, 100))});
+        }
+        for (const DataPoint& pt : batch) {
+            single.enqueue(pt);
+        }
+        batched.enqueueAll(std::move(batch));
+        batched.debugConfirmInternalArray();
+
+        int n = randomInteger(0, batched.size() / 2);
+        vector<DataPoint> taken;
+        batched.dequeueMany(n, back_inserter(taken));
+        batched.debugConfirmInternalArray();
+        for (int i = 0; i < n; i++) {
+            EXPECT_EQUAL(taken[i].priority, single.dequeue().priority);
+        }
+        EXPECT_EQUAL(batched.size(), single.size());
+    }
+}
+
+void dequeueEach(PQHeap& pq, DataPoint* out, int n) {
+    for (int i = 0; i < n; i++) {
+        out[i] = pq.dequeue();
+    }
+}
+
+STUDENT_TEST("PQHeap: time enqueueAll and dequeueMany against single operations") {
+    for (int n = 1000000; n <= 4000000; n *= 2) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"", randomReal(0, 10)});
+        }
+        Vector<DataPoint> small;
+        for (int i = 0; i < n / 100; i++) {
+            small.add({"", randomReal(0, 10)});
+        }
+        Vector<DataPoint> copy = input, smallCopy = small;
+        PQHeap single, batched;
+
+        TIME_OPERATION(n, enqueueEach(single, copy));           // whole batch into an empty heap
+        TIME_OPERATION(n, batched.enqueueAll(input));
+        TIME_OPERATION(small.size(), enqueueEach(single, smallCopy)); // 1% batch into a full heap
+        TIME_OPERATION(small.size(), batched.enqueueAll(small));
+
+        vector<DataPoint> out(single.size());
+        TIME_OPERATION(n, dequeueEach(single, out.data(), single.size()));
+        TIME_OPERATION(n, batched.dequeueMany(batched.size(), out.data()));
+    }
+}
+
+void fillWithGrowth(PQHeap& pq, int n, double factor, bool reserveFirst) {
+    pq.setGrowthFactor(factor);
+    if (reserveFirst) {
+        pq.reserve(n);
+    }
+    for (int i = 0; i < n; i++) {
+        pq.enqueue({"", double((int64_t(i) * 7919) % n)});
+    }
+}
+
+STUDENT_TEST("PQHeap: time filling with reserve and different growth factors, then shrink after the spike") {
+    int n = 10000000;
+    for (double factor : { 1.25, 2.0, 4.0 }) {
+        PQHeap pq;
+        TIME_OPERATION(n, fillWithGrowth(pq, n, factor, false));
+    }
+    PQHeap reserved;
+    TIME_OPERATION(n, fillWithGrowth(reserved, n, 2.0, true));
+    EXPECT_EQUAL(reserved.capacity(), n);
+
+    emptyQueue(reserved, n - 1000);
+    reserved.shrinkToFit();
+    EXPECT_EQUAL(reserved.capacity(), 1000);
+}
@@ -1,30 +1,106 @@
 #pragma once
 #include "MemoryUtils.h"
 #include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
 #include "vector.h"
+#include <climits>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 /**
- * Priority queue of DataPoints implemented using a binary heap.
+ * Default ordering for BasicPQHeap. An element is more urgent than another
+ * when its priority field is smaller, which is the ordering PQHeap has always
+ * used for DataPoints. Any element type with a priority member works with it.
+ */
+struct LowerPriorityFirst {
+    template <typename T>
+    bool operator()(const T& lhs, const T& rhs) const {
+        return lhs.priority < rhs.priority;
+    }
+};
+
+/**
+ * Priority queue implemented using a binary heap.
+ *
+ * The element type T and the ordering Compare are template parameters.
+ * compare(a, b) must return true when a is more urgent than b, i.e. when a
+ * should be dequeued before b. Elements are moved (never copied) as they
+ * travel through the heap, so T only needs to be movable; move-only types such
+ * as structs holding a unique_ptr work, and so do types without a default
+ * constructor.
+ *
+ * Slots past the last element are left unconstructed, so growing the array
+ * moves each element once into fresh storage instead of default-constructing
+ * the whole new array first. reserve, shrinkToFit and setGrowthFactor give
+ * callers control over how much memory the queue holds.
+ *
+ * PQHeap (declared below the class) is the DataPoint instantiation used by the
+ * rest of the project.
  */
-class PQHeap {
+template <typename T, typename Compare = LowerPriorityFirst>
+class BasicPQHeap {
 public:
     /**
-     * Creates a new, empty priority queue.
+     * Creates a new, empty priority queue that orders elements using compare.
      */
-    PQHeap();
+    explicit BasicPQHeap(Compare compare = Compare());
 
     /**
      * Cleans up all memory allocated by this priority queue.
      */
-    ~PQHeap();
+    ~BasicPQHeap();
 
     /**
      * Adds a new element into the queue. This operation runs in time O(log n),
-     * where n is the number of elements in the queue.
+     * where n is the number of elements in the queue. The rvalue overload moves
+     * the element into the queue instead of copying it.
      *
      * @param element The element to add.
      */
-    void enqueue(DataPoint element);
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Constructs a new element from args and adds it to the queue. Types that
+     * have a matching constructor are built with it; aggregates such as
+     * DataPoint are brace-initialized, so emplace("label", 2.5) enqueues the
+     * DataPoint {"label", 2.5}. The element is built as a temporary and then
+     * moved into the heap, so this saves the caller naming a T but not the
+     * move that enqueue(T&&) makes.
+     *
+     * This operation runs in time O(log n).
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Replaces the contents of the queue with the elements of v. The elements
+     * are moved (not copied) into a single allocation sized for v and then
+     * arranged into a heap bottom-up, which takes O(n) comparisons instead of
+     * the O(n log n) of n separate enqueue calls. v is left empty.
+     *
+     * Vector does not hand out its internal buffer, so the elements are moved
+     * rather than the buffer being adopted; no element is ever copied.
+     *
+     * @param v The elements to build the queue from.
+     */
+    void buildFrom(Vector<T>&& v);
+
+    /**
+     * Adds every element of range (anything with begin() and end(), such as a
+     * Vector) to the queue. The array grows at most once for the whole batch.
+     * A batch smaller than the current queue is percolated up element by
+     * element; a larger one is appended as is and the whole array re-heapified,
+     * which is O(n + count) instead of O(count log n). Elements are moved out of
+     * range if it is an rvalue and copied otherwise.
+     *
+     * @param range The elements to add.
+     */
+    template <typename Range>
+    void enqueueAll(Range&& range);
 
     /**
      * Removes and returns the element that is frontmost in this priority queue.
@@ -38,9 +114,35 @@ public:
      *
      * This operation must run in time O(log n).
      *
-     * @return The frontmost element, which is removed from queue.
+     * @return The frontmost element, which is moved out of the queue.
      */
-    DataPoint dequeue();
+    T dequeue();
+
+    /**
+     * Removes the n frontmost elements and writes them, frontmost first, to
+     * out, which can be a pointer into the caller's buffer or any other output
+     * iterator. Returns out advanced past the last element written. If n is
+     * negative or more than size(), this function calls error().
+     *
+     * This operation runs in time O(n log size()).
+     */
+    template <typename OutputIt>
+    OutputIt dequeueMany(int n, OutputIt out);
+
+    /**
+     * Removes the frontmost element and adds element in its place, returning
+     * the removed element. This is equivalent to a dequeue followed by an
+     * enqueue, but restores the heap order with a single percolate-down.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     *
+     * @param element The element to add.
+     * @return The former frontmost element.
+     */
+    T replaceTop(const T& element);
+    T replaceTop(T&& element);
 
     /**
      * Returns, but does not remove, the element that is frontmost.
@@ -49,9 +151,9 @@ public:
      *
      * This operation must run in time O(1).
      *
-     * @return frontmost element
+     * @return A reference to the frontmost element, valid until the queue is next modified.
      */
-    DataPoint peek() const;
+    const T& peek() const;
 
     /**
      * Returns whether this priority queue is empty.
@@ -72,12 +174,39 @@ public:
     int size() const;
 
     /**
-     * Removes all elements from the priority queue.
-     *
-     * This operation must run in time O(1).
+     * Removes all elements from the priority queue. The elements are destroyed,
+     * which takes time O(n) unless T has a trivial destructor, but the allocated
+     * capacity is kept for reuse; call shrinkToFit afterwards to release it.
      */
     void clear();
 
+    /**
+     * Returns the number of elements the queue can hold before it has to grow.
+     */
+    int capacity() const;
+
+    /**
+     * Makes sure the queue can hold at least capacity elements without growing
+     * again, so a caller that knows how many elements are coming pays for a
+     * single allocation. Never shrinks the queue. If capacity is negative, this
+     * function calls error().
+     */
+    void reserve(int capacity);
+
+    /**
+     * Releases any allocated capacity beyond size(), for instance after a spike
+     * of elements has drained away.
+     */
+    void shrinkToFit();
+
+    /**
+     * Sets the factor by which the capacity is multiplied each time the queue
+     * runs out of room (2 by default). Smaller factors waste less memory, larger
+     * ones reallocate less often. If factor is not greater than 1, this function
+     * calls error().
+     */
+    void setGrowthFactor(double factor);
+
     /*
      * These three "debug" functions are intended solely for testing.
      * They provide controlled access to the queue's private internal array.
@@ -90,6 +219,7 @@ public:
      * internal array as part of a hand-constructed test case.
      * Such debug functions would typically be used early in development
      * and could be removed (or made private) once past the need for them.
+     * The last two copy elements, so they are only available when T is copyable.
      */
 
     /*
@@ -100,14 +230,14 @@ public:
     /*
      * Return a Vector copy of the elements from the internal array.
      */
-    Vector<DataPoint> debugGetInternalArrayContents() const;
+    Vector<T> debugGetInternalArrayContents() const;
 
     /*
      * Allocate the internal array to requested capacity and copy the elements
      * from vector v into the internal array. The new contents of the internal
      * array are confirmed by a call to debugConfirmInternalArray.
      */
-    void debugSetInternalArrayContents(const Vector<DataPoint>& v, int capacity);
+    void debugSetInternalArrayContents(const Vector<T>& v, int capacity);
 
 private:
 
@@ -115,14 +245,28 @@ private:
 
     //--------------------------------------
 
-    void expandAllocation(); // expands the number of allocated spots in the array by a factor of 2
+    static const int INITIAL_CAPACITY = 10;    // starting number of allocated slots
+    static const int NONE = -1;                // used as sentinel index
+    static constexpr double DEFAULT_GROWTH_FACTOR = 2.0;
+
+    void expandAllocation(); // grows the array by the growth factor so at least one more element fits
+    int grownCapacity(int needed) const; // the capacity to grow to so that needed elements fit
+    void reallocate(int capacity); // moves the elements into new, otherwise unconstructed storage of capacity slots
+    static T* allocateSlots(int capacity); // raw storage for capacity elements, none of them constructed
+    void releaseSlots(); // destroys the elements and frees the storage
     void validateIndex(int index) const; // function validates given index
-    void percolateDown(); // function called by dequeue to percolate down and swap vals
+    void percolateUp(int hole, T&& element); // moves the hole up past less urgent parents, then fills it with element
+    void percolateDown(int hole, T&& element); // moves the hole down past more urgent children, then fills it with element
+    void place(T&& element); // appends element at the end of the array and percolates it up
+    void append(T&& element, bool percolate); // enqueueAll's place, with room already made
+    void heapify(); // restores the heap property over the whole array, bottom-up
 
 
-    DataPoint* _elements;   // dynamic array
+    T* _elements;           // dynamic array; only the first _numFilled slots hold constructed elements
     int _numAllocated;      // number of slots allocated in array
     int _numFilled;         // number of slots filled in array
+    double _growthFactor;   // expandAllocation multiplies _numAllocated by this
+    Compare _compare;       // compare(a, b) is true when a is more urgent than b
 
     //--------------------------------------
 
@@ -133,7 +277,6 @@ private:
     int getParentIndex(int child) const;
     int getLeftChildIndex(int parent) const;
     int getRightChildIndex(int parent) const;
-    void swapElements(int indexA, int indexB);
 
     /* Weird C++isms: C++ loves to make copies of things, which is usually a good thing but
      * for the purposes of this assignment requires some C++ knowledge we haven't yet covered.
@@ -142,5 +285,542 @@ private:
      *
      * Curious what this does? Take CS106L!
      */
-    DISALLOW_COPYING_OF(PQHeap);
+    DISALLOW_COPYING_OF(BasicPQHeap);
 };
+
+/**
+ * Priority queue of DataPoints implemented using a binary heap.
+ */
+using PQHeap = BasicPQHeap<DataPoint>;
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+/*
+ * Because BasicPQHeap is a template, its member functions have to be visible
+ * to every file that instantiates it, so they live here rather than in
+ * pqheap.cpp. pqheap.cpp holds the test cases.
+ */
+
+/*
+ * This constructor initializes the heap object and assigns _numAllocated to the initial capacity,
+ * allocates the (unconstructed) array of elements, _elements, sets numFilled = 0, and stores the comparator.
+ */
+template <typename T, typename Compare>
+BasicPQHeap<T, Compare>::BasicPQHeap(Compare compare) : _compare(std::move(compare)) {
+    _numAllocated = INITIAL_CAPACITY;
+    _elements = allocateSlots(_numAllocated);
+    _numFilled = 0;
+    _growthFactor = DEFAULT_GROWTH_FACTOR;
+}
+
+/*
+ * This destructor destroys the elements and frees the array to avoid any memory allocation issues
+ */
+template <typename T, typename Compare>
+BasicPQHeap<T, Compare>::~BasicPQHeap() {
+    releaseSlots();
+}
+
+// this helper, allocateSlots, gets raw storage for capacity elements from std::allocator, which respects
+// T's alignment. No element is constructed until it is placed in a slot.
+template <typename T, typename Compare>
+T* BasicPQHeap<T, Compare>::allocateSlots(int capacity){
+    return std::allocator<T>().allocate(size_t(capacity));
+}
+
+// this helper, releaseSlots, destroys the filled slots and hands the storage back to the allocator.
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::releaseSlots(){
+    std::destroy(_elements, _elements + _numFilled);
+    std::allocator<T>().deallocate(_elements, size_t(_numAllocated));
+}
+
+// this function, expandAllocation, grows the allocated capacity of our heap by the growth factor. It is
+// typically called when the numfilled = _numAllocated.
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::expandAllocation(){
+    reallocate(grownCapacity(size() + 1));
+}
+
+// this helper, grownCapacity, multiplies the capacity by the growth factor until needed elements fit,
+// always growing by at least one slot so that factors close to 1 still make progress.
+template <typename T, typename Compare>
+int BasicPQHeap<T, Compare>::grownCapacity(int needed) const {
+    int capacity = _numAllocated;
+    while (capacity < needed){
+        double grown = capacity * _growthFactor;
+        capacity = grown < capacity + 1 ? capacity + 1 : (grown > INT_MAX ? INT_MAX : int(grown));
+    }
+    return capacity;
+}
+
+// this helper, reallocate, allocates unconstructed storage of the given capacity, move-constructs the
+// filled slots into it and frees the old one. Unlike new T[capacity], nothing is default-constructed
+// only to be assigned over.
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::reallocate(int capacity){
+
+    T *newArray = allocateSlots(capacity);
+    std::uninitialized_move(_elements, _elements + _numFilled, newArray);
+
+    releaseSlots();
+
+    _elements = newArray;
+    _numAllocated = capacity;
+}
+
+/*
+ * These methods, enqueue, take an element and add it to the end of the array, then percolate
+ * it up comparing each spot to its parent to properly assign it to the queue. The const& overload
+ * copies the element in, the && overload moves it.
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::enqueue(const T& elem) {
+    place(T(elem));
+}
+
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::enqueue(T&& elem) {
+    place(std::move(elem));
+}
+
+/*
+ * This method, emplace, builds the new element from args and hands it to place. Aggregates
+ * have no constructor to forward to, so they get brace initialization instead.
+ */
+template <typename T, typename Compare>
+template <typename... Args>
+void BasicPQHeap<T, Compare>::emplace(Args&&... args) {
+    if constexpr (std::is_constructible<T, Args&&...>::value) {
+        place(T(std::forward<Args>(args)...));
+    } else {
+        place(T{std::forward<Args>(args)...});
+    }
+}
+
+/*
+ * This helper, place, makes sure the first free slot of the array is allocated (growing it if full)
+ * and has append percolate elem up to its proper spot from there.
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::place(T&& elem) {
+
+    if (size() == _numAllocated){
+        expandAllocation();
+    }
+
+    append(std::move(elem), true);
+}
+
+/*
+ * This method, enqueueAll, makes room for the whole batch up front, growing the capacity as many times
+ * as needed but moving the elements only once, and then appends every element. Percolating each one up
+ * costs up to log n comparisons apiece, while re-heapifying costs about 2 per slot of the whole
+ * array, so the batch is only percolated when it is smaller than what is already in the heap.
+ */
+template <typename T, typename Compare>
+template <typename Range>
+void BasicPQHeap<T, Compare>::enqueueAll(Range&& range) {
+    int count = int(std::distance(std::begin(range), std::end(range)));
+    int total = size() + count;
+    if (total > _numAllocated){
+        reallocate(grownCapacity(total));
+    }
+
+    bool percolate = count < size();
+    for (auto&& element : range){
+        if constexpr (std::is_lvalue_reference<Range>::value) {
+            append(T(element), percolate);
+        } else {
+            append(std::move(element), percolate);
+        }
+    }
+
+    if (!percolate){
+        heapify();
+    }
+}
+
+/*
+ * This helper, append, fills the first free slot with elem, percolating it up if asked to. The
+ * caller has already made sure the slot is allocated. The free slot holds no object yet, so it is
+ * move-constructed from whichever element ends up there: elem itself if it does not outrank its
+ * parent, and otherwise the parent, which leaves a hole in a constructed slot for percolateUp to
+ * carry on from. No T is ever default-constructed.
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::append(T&& elem, bool percolate) {
+    int hole = size();
+    int parentIdx = getParentIndex(hole);
+
+    if (!percolate || parentIdx == NONE || !_compare(elem, _elements[parentIdx])){
+        ::new (static_cast<void*>(_elements + hole)) T(std::move(elem));
+        _numFilled ++;
+        return;
+    }
+
+    ::new (static_cast<void*>(_elements + hole)) T(std::move(_elements[parentIdx]));
+    _numFilled ++;
+    percolateUp(parentIdx, std::move(elem));
+}
+
+/*
+ * This method, buildFrom, discards the current contents, reallocates the array to fit v exactly
+ * (but never below the initial capacity), moves every element of v across and heapifies the result.
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::buildFrom(Vector<T>&& v) {
+    int count = v.size();
+    int capacity = count > INITIAL_CAPACITY ? count : INITIAL_CAPACITY;
+
+    clear();
+    if (capacity != _numAllocated){
+        releaseSlots();
+        _elements = allocateSlots(capacity);
+        _numAllocated = capacity;
+    }
+
+    for (int i = 0; i < count; i++){
+        ::new (static_cast<void*>(_elements + i)) T(std::move(v[i]));
+    }
+    _numFilled = count;
+    v.clear();
+
+    heapify();
+}
+
+/*
+ * This helper, heapify, percolates down every element that has children, starting from the
+ * last parent and working back to the root. Each subtree is already a heap by the time its
+ * root is visited, and because most nodes sit near the bottom and only move a short way,
+ * the total work is O(n).
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::heapify() {
+    for (int i = getParentIndex(size() - 1); i >= 0; i--){
+        T element = std::move(_elements[i]);
+        percolateDown(i, std::move(element));
+    }
+}
+
+/*
+ * This method, peek(), returns the first element in the queue (without dequeueing it).
+ */
+template <typename T, typename Compare>
+const T& BasicPQHeap<T, Compare>::peek() const {
+    if (isEmpty()){
+        error("Cannot peek because PQHeap is empty!");
+    }
+    return _elements[0];
+}
+
+/*
+ * This method, dequeue, removes the most urgent element from the queue, returning it, which leaves a hole
+ * at the root. The last element of the array is taken out and percolateDown moves the hole down comparing
+ * that element to the children to find its proper priority spot.
+ */
+template <typename T, typename Compare>
+T BasicPQHeap<T, Compare>::dequeue() {
+    if (isEmpty()){
+        error("Cannot dequeue because PQHeap is empty!");
+    }
+
+    int lastIdx = size() - 1;
+    int firstIdx = 0;
+
+    T deQueuedData = std::move(_elements[firstIdx]);
+    _numFilled --;
+
+    // re-seat the former last element, starting from the hole left at the root
+    if (lastIdx != firstIdx){
+        percolateDown(firstIdx, std::move(_elements[lastIdx]));
+    }
+    std::destroy_at(_elements + lastIdx);
+
+    return deQueuedData;
+}
+
+/*
+ * This method, dequeueMany, checks the count once and then removes the root n times, moving each
+ * element straight into the caller's buffer instead of returning it by value.
+ */
+template <typename T, typename Compare>
+template <typename OutputIt>
+OutputIt BasicPQHeap<T, Compare>::dequeueMany(int n, OutputIt out) {
+    if (n < 0 || n > size()){
+        error("Cannot dequeueMany " + integerToString(n) + " elements from PQHeap of size "
+              + integerToString(size()) + "!");
+    }
+
+    for (int i = 0; i < n; i++){
+        *out = std::move(_elements[0]);
+        ++out;
+        _numFilled --;
+
+        if (_numFilled > 0){
+            percolateDown(0, std::move(_elements[_numFilled]));
+        }
+        std::destroy_at(_elements + _numFilled);
+    }
+    return out;
+}
+
+/*
+ * These methods, replaceTop, move the root out and seat the new element starting from the hole it
+ * leaves, so the element walks down from the root once instead of being appended and percolated
+ * up after a separate dequeue.
+ */
+template <typename T, typename Compare>
+T BasicPQHeap<T, Compare>::replaceTop(const T& elem) {
+    return replaceTop(T(elem));
+}
+
+template <typename T, typename Compare>
+T BasicPQHeap<T, Compare>::replaceTop(T&& elem) {
+    if (isEmpty()){
+        error("Cannot replaceTop because PQHeap is empty!");
+    }
+
+    T replaced = std::move(_elements[0]);
+    percolateDown(0, std::move(elem));
+    return replaced;
+}
+
+/*
+ * This method, isEmpty, returns true if the array/queue is empty, false otherwise
+ */
+template <typename T, typename Compare>
+bool BasicPQHeap<T, Compare>::isEmpty() const {
+    return size() == 0;
+}
+
+/*
+ * This method, size, returns the number of filled spots in the queue
+ */
+template <typename T, typename Compare>
+int BasicPQHeap<T, Compare>::size() const {
+    // return the number of filled spots
+    return _numFilled;
+}
+
+/*
+ * this method destroys the elements and sets the number of filled spots in the queue/heap/array to be zero
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::clear() {
+    std::destroy(_elements, _elements + _numFilled);
+    // set the number of filled spots to zero
+    _numFilled = 0;
+}
+
+/*
+ * This method, capacity, returns the number of allocated spots in the array
+ */
+template <typename T, typename Compare>
+int BasicPQHeap<T, Compare>::capacity() const {
+    return _numAllocated;
+}
+
+/*
+ * This method, reserve, reallocates straight to the requested capacity if it is more than what is
+ * allocated now; the growth factor plays no part.
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::reserve(int capacity) {
+    if (capacity < 0){
+        error("Cannot reserve a negative capacity " + integerToString(capacity) + " for PQHeap!");
+    }
+    if (capacity > _numAllocated){
+        reallocate(capacity);
+    }
+}
+
+/*
+ * This method, shrinkToFit, reallocates the array to exactly the filled size
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::shrinkToFit() {
+    if (size() < _numAllocated){
+        reallocate(size());
+    }
+}
+
+/*
+ * This method, setGrowthFactor, changes the factor expandAllocation grows by from now on
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::setGrowthFactor(double factor) {
+    if (!(factor > 1)){
+        error("PQHeap growth factor must be greater than 1, not " + realToString(factor) + "!");
+    }
+    _growthFactor = factor;
+}
+
+/*
+ * We strongly recommend implementing this helper function, which
+ * calculates the index of the element that is the parent of the
+ * specified child index. If this child has no parent, return
+ * the sentinel value NONE.
+ */
+template <typename T, typename Compare>
+int BasicPQHeap<T, Compare>::getParentIndex(int child) const {
+    if (child <= 0){
+        return NONE;
+    }
+    int parentIndex = (child - 1) / 2;
+    return parentIndex;
+}
+
+/*
+ * We strongly recommend implementing this helper function, which
+ * calculates the index of the element that is the left child of the
+ * specified parent index. If this parent has no left child, return
+ * the sentinel value NONE.
+ */
+template <typename T, typename Compare>
+int BasicPQHeap<T, Compare>::getLeftChildIndex(int parent) const {
+
+    if (parent < 0){
+        return NONE;
+    }
+
+    int leftChildIndex = (2 * parent) + 1;
+
+    if (leftChildIndex >= _numFilled){
+        return NONE;
+    }
+
+    return leftChildIndex;
+}
+
+/*
+ * We strongly recommend implementing this helper function, which
+ * calculates the index of the element that is the right child of the
+ * specified parent index. If this parent has no right child, return
+ * the sentinel value NONE.
+ */
+template <typename T, typename Compare>
+int BasicPQHeap<T, Compare>::getRightChildIndex(int parent) const {
+
+    if (parent < 0){
+        return NONE;
+    }
+
+    int rightChildIndex = (2 * parent) + 2;
+
+    if (rightChildIndex >= _numFilled){
+        return NONE;
+    }
+
+    return rightChildIndex;
+}
+
+/*
+ * To confirm the validity of the internal array, you must check that
+ * the heap property holds for all elements in the array. If elements are
+ * found that violate the heap property, report an error.
+ */
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::debugConfirmInternalArray() const {
+
+    if (_numFilled > _numAllocated) error("Too many elements in not enough space!");
+
+    for (int i = _numFilled - 1; i > 0; i --){
+        if (_compare(_elements[i], _elements[getParentIndex(i)])){
+            error("PQHeap index: " + integerToString(i) + " is out of order with its parent!");
+        }
+    }
+}
+
+// This method, debugGetInternalArrayContents, serves as a helper for debugging by creating a vector copy
+// of the elements in the queue, returning it.
+template <typename T, typename Compare>
+Vector<T> BasicPQHeap<T, Compare>::debugGetInternalArrayContents() const {
+    Vector<T> v;
+
+    for (int i = 0; i < size(); i++) {
+        v.add(_elements[i]);
+    }
+    return v;
+}
+
+// This method, debugSetInternalArrayContents, takes a vector of elements and a capacity
+// and creates a new element queue inputting vector elements into that queue.
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::debugSetInternalArrayContents(const Vector<T>& v, int capacity) {
+    if (v.size() > capacity || capacity == 0) {
+        error("Invalid capacity for debugSetInternalArrayContents!");
+    }
+    releaseSlots();                         // discard old memory
+    _elements = allocateSlots(capacity);    // allocate new memory
+    _numAllocated = capacity;
+    _numFilled = v.size();
+    for (int i = 0; i < v.size(); i++) {    // fill contents with copy from vector
+        ::new (static_cast<void*>(_elements + i)) T(v[i]);
+    }
+    debugConfirmInternalArray();            // confirm contents valid
+}
+
+// This method, validate index, takes an index and raises an error if that index is invalid/out of bounds.
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::validateIndex(int index) const {
+    if (index < 0 || index >= _numFilled) error("Invalid index " + integerToString(index));
+}
+
+// this helper method, percolateUp, treats index hole as empty and, for as long as element is more
+// urgent than the hole's parent, shifts that parent down into the hole and moves the hole up to the
+// parent's spot. element is written exactly once, into the final hole, so each level of the walk costs
+// one move instead of the three a swap would take.
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::percolateUp(int hole, T&& element){
+    validateIndex(hole);
+
+    int parentIdx = getParentIndex(hole);
+    while (parentIdx != NONE && _compare(element, _elements[parentIdx])){
+        _elements[hole] = std::move(_elements[parentIdx]);
+        hole = parentIdx;
+        parentIdx = getParentIndex(hole);
+    }
+
+    _elements[hole] = std::move(element);
+}
+
+// this helper method, percolateDown, treats index hole as empty and performs the percolate down
+// process: the more urgent child is shifted up into the hole for as long as it is more urgent than
+// element, and element is written once into the spot where the hole comes to rest.
+template <typename T, typename Compare>
+void BasicPQHeap<T, Compare>::percolateDown(int hole, T&& element){
+    validateIndex(hole);
+
+    while (true){
+        int lcIdx = getLeftChildIndex(hole);
+        int rcIdx = getRightChildIndex(hole);
+
+        // no children means we have reached the bottom of the heap
+
+        if (lcIdx == NONE){
+            break;
+        }
+
+        // find more urgent of both children
+
+        int smallestOfChildren = lcIdx;
+        if (rcIdx != NONE && _compare(_elements[rcIdx], _elements[lcIdx])){
+            smallestOfChildren = rcIdx;
+        }
+
+        // stop once element is no less urgent than the best child
+
+        if (!_compare(_elements[smallestOfChildren], element)){
+            break;
+        }
+
+        // if we found a more urgent child = pull it up and keep going
+
+        _elements[hole] = std::move(_elements[smallestOfChildren]);
+        hole = smallestOfChildren;
+    }
+
+    _elements[hole] = std::move(element);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "pqheap.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Priority queue of DataPoints laid out as a struct of arrays.
+ *
+ * PQHeap stores whole DataPoints in its heap array, so every comparison
+ * during percolation touches a 40-byte element of which only the 8-byte
+ * priority matters, and a cache line holds about one and a half keys. Here
+ * the heap array holds only 16-byte (priority, index) pairs, four to a cache
+ * line, and each label lives in a separate payload array at the index its
+ * pair names. Percolation never touches the payloads: a label is written into
+ * its slot once on enqueue and moved out once on dequeue, after which the slot
+ * is reused. The only other time labels move is when the payload array grows
+ * and, like any std::vector, relocates its strings.
+ *
+ * Elements of equal priority are dequeued in arbitrary order, as for PQHeap.
+ */
+class SoAPQHeap {
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    SoAPQHeap();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time O(log n).
+     */
+    void enqueue(const DataPoint& element);
+    void enqueue(DataPoint&& element);
+
+    /**
+     * Removes and returns the frontmost element. If the priority queue is
+     * empty, this function calls error(). This operation runs in time O(log n).
+     */
+    DataPoint dequeue();
+
+    /**
+     * Returns the label and priority of the frontmost element. The label
+     * reference is valid until the queue is next modified. If the priority
+     * queue is empty, this function calls error().
+     */
+    const std::string& peekLabel() const;
+    double peekPriority() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue and frees their labels. The
+     * key and payload arrays keep their capacity for reuse.
+     */
+    void clear();
+
+private:
+    /* What the heap array holds: a key and the payload slot of its label. */
+    struct Key {
+        double priority;
+        uint32_t index;
+    };
+
+    uint32_t claimSlot(); // a free payload slot, reusing a vacated one when there is one
+
+    BasicPQHeap<Key> _keys;
+    std::vector<std::string> _labels;   // payload array; _labels[key.index] is that key's label
+    std::vector<uint32_t> _freeSlots;   // indexes into _labels not used by any key
+
+    DISALLOW_COPYING_OF(SoAPQHeap);
+};
@@ -0,0 +1,159 @@
+/*
+ * This file, staticpqheap, holds the test cases for the StaticPQHeap class template defined in staticpqheap.h,
+ * and a time trial of many small top-k selections that also counts their allocations (with allocationcounter,
+ * in builds configured with count_allocations).
+ */
+#include "staticpqheap.h"
+#include "allocationcounter.h"
+#include "boundedtopk.h"
+#include "pqheap.h"
+#include "random.h"
+#include "SimpleTest.h"
+#include <iostream>
+using namespace std;
+
+template class StaticPQHeap<64, DataPoint>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("StaticPQHeap: example from PQHeap writeup, up to capacity and back") {
+    StaticPQHeap<9> pq;
+    EXPECT_EQUAL(pq.capacity(), 9);
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+    EXPECT_ERROR(pq.replaceTop({"", 1}));
+
+    Vector<DataPoint> input = {
+        {"R", 4}, {"A", 5}, {"B", 3}, {"K", 7}, {"G", 2},
+        {"V", 9}, {"T", 1}, {"O", 8}, {"S", 6} };
+    for (const DataPoint& dp : input) {
+        pq.enqueue(dp);
+        pq.debugConfirmInternalArray();
+    }
+    EXPECT(pq.isFull());
+    EXPECT_ERROR(pq.enqueue({"one too many", 0}));
+    EXPECT_EQUAL(pq.size(), 9);
+    EXPECT_EQUAL(pq.peek(), {"T", 1});
+
+    EXPECT_EQUAL(pq.replaceTop({"Z", 10}), {"T", 1});
+    EXPECT_EQUAL(pq.dequeue(), {"G", 2});
+    DataPoint out[3];
+    pq.dequeueMany(3, out);
+    EXPECT_EQUAL(out[0], {"B", 3});
+    EXPECT_EQUAL(out[2], {"A", 5});
+    EXPECT_ERROR(pq.dequeueMany(6, out));
+    for (int priority : {6, 7, 8, 9, 10}) {
+        EXPECT_EQUAL(pq.dequeue().priority, priority);
+    }
+    EXPECT(pq.isEmpty());
+
+    pq.enqueue({"a label well past the small-string limit", 1});
+    pq.clear();
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("StaticPQHeap: random operations match PQHeap at every capacity from 1 to 64") {
+    setRandomSeed(25);
+    for (int round = 0; round < 2000; round++) {
+        StaticPQHeap<64> pq;
+        StaticPQHeap<1> single;
+        PQHeap reference;
+        int limit = randomInteger(1, 64);
+        for (int i = 0; i < 200; i++) {
+            if (reference.isEmpty() || (reference.size() < limit && randomChance(0.6))) {
+                DataPoint elem = {"", double(randomInteger(0, 20))};
+                pq.enqueue(elem);
+                reference.enqueue(elem);
+            } else if (randomChance(0.5)) {
+                EXPECT_EQUAL(pq.dequeue().priority, reference.dequeue().priority);
+            } else {
+                DataPoint elem = {"", double(randomInteger(0, 20))};
+                EXPECT_EQUAL(pq.replaceTop(elem).priority, reference.replaceTop(elem).priority);
+            }
+            EXPECT_EQUAL(pq.size(), reference.size());
+        }
+        pq.debugConfirmInternalArray();
+
+        single.enqueue({"", 2});
+        EXPECT_EQUAL(single.replaceTop({"", 1}).priority, 2);
+        EXPECT_EQUAL(single.dequeue().priority, 1);
+    }
+}
+
+/* An element type with no default constructor, which the inline slots must never need. */
+struct Ticket {
+    explicit Ticket(int p) : priority(p) {}
+    int priority;
+};
+
+STUDENT_TEST("StaticPQHeap: element types without a default constructor work") {
+    StaticPQHeap<16, Ticket> pq;
+    for (int i = 0; i < 16; i++) {
+        pq.enqueue(Ticket((i * 7) % 16));
+        pq.debugConfirmInternalArray();
+    }
+    EXPECT_EQUAL(pq.replaceTop(Ticket(16)).priority, 0);
+    for (int i = 1; i <= 16; i++) {
+        EXPECT_EQUAL(pq.dequeue().priority, i);
+    }
+}
+
+STUDENT_TEST("StaticPQHeap: BoundedTopK on it matches the default one and allocates nothing") {
+    setRandomSeed(26);
+    Vector<DataPoint> input;
+    for (int i = 0; i < 5000; i++) {
+        input.add({"L" + integerToString(randomInteger(0, 99)), double(randomInteger(0, 100))});
+    }
+    for (int k : {0, 1, 5, 16, 63, 64}) {
+        BoundedTopK<DataPoint, PriorityThenLabelRank> reference(k);
+        BoundedTopK<DataPoint, PriorityThenLabelRank, StaticPQHeap<64, DataPoint, PriorityThenLabelRank>> best(k);
+        long before = allocationCount();
+        for (const DataPoint& pt : input) {
+            best.offer(pt);
+        }
+        EXPECT_EQUAL(allocationCount() - before, 0);    // short labels fit in the small-string buffer; 0 - 0 if not counting
+        for (const DataPoint& pt : input) {
+            reference.offer(pt);
+        }
+        EXPECT_EQUAL(best.takeDescending(), reference.takeDescending());
+    }
+    using TooSmall = BoundedTopK<DataPoint, LowerPriorityFirst, StaticPQHeap<8>>;
+    EXPECT_ERROR(TooSmall tooBig(9));
+}
+
+/* Runs one bounded top-k of k points per slice of the input, the way a GUI calls topK once per redraw. */
+template <typename TopK>
+static void topKPerSlice(const Vector<DataPoint>& input, int sliceLength, int k, long& allocations) {
+    long before = allocationCount();
+    for (int start = 0; start + sliceLength <= input.size(); start += sliceLength) {
+        TopK best(k);
+        for (int i = start; i < start + sliceLength; i++) {
+            best.offer(input[i]);
+        }
+        Vector<DataPoint> winners = best.takeDescending();
+    }
+    allocations = allocationCount() - before;
+}
+
+STUDENT_TEST("StaticPQHeap: time many small top-k selections against BasicPQHeap, counting allocations") {
+    Vector<DataPoint> input;
+    for (int i = 0; i < 1000000; i++) {
+        input.add({"", randomReal(0, 10)});
+    }
+    for (int k : {5, 16, 64}) {
+        for (int sliceLength : {50, 1000}) {
+            int calls = input.size() / sliceLength;
+            long dynamicAllocations, staticAllocations;
+            TIME_OPERATION(calls, (topKPerSlice<BoundedTopK<DataPoint>>(input, sliceLength, k, dynamicAllocations)));
+            TIME_OPERATION(calls, (topKPerSlice<BoundedTopK<DataPoint, LowerPriorityFirst, StaticPQHeap<64>>>(
+                                       input, sliceLength, k, staticAllocations)));
+            if (countingAllocations()) {
+                cout << "    k = " << k << ", " << sliceLength << " points per call: "
+                     << double(dynamicAllocations) / calls << " allocations per call with BasicPQHeap, "
+                     << double(staticAllocations) / calls << " with StaticPQHeap" << endl;
+            }
+        }
+    }
+}
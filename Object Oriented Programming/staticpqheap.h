@@ -0,0 +1,312 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include "strlib.h"
+#include <memory>
+#include <new>
+#include <utility>
+
+/**
+ * Priority queue implemented using a binary heap of at most Capacity elements,
+ * stored inline in the object itself instead of in a separately allocated
+ * array. A StaticPQHeap declared as a local variable lives entirely on the
+ * stack, so creating, filling and destroying one allocates nothing (beyond
+ * whatever the elements allocate themselves).
+ *
+ * This is meant for the small, fixed bounds of a top-k with a handful of
+ * survivors. Capacity is limited to 64, so the heap is at most 7 levels deep
+ * and every percolation loop runs a number of steps the compiler knows up
+ * front; the index checks BasicPQHeap makes on each step are left out, since
+ * no index can leave the inline array. Slots past the last element are left
+ * unconstructed, as in BasicPQHeap, so an empty queue costs nothing to create
+ * even when T has a non-trivial constructor, and T needs no default
+ * constructor at all.
+ *
+ * The interface is the subset of BasicPQHeap's that BoundedTopK uses, plus
+ * dequeue and isFull, so the two can stand in for one another as long as the
+ * queue never grows past Capacity: an enqueue into a full queue calls error().
+ */
+template <int Capacity, typename T = DataPoint, typename Compare = LowerPriorityFirst>
+class StaticPQHeap {
+    static_assert(Capacity >= 1 && Capacity <= 64, "StaticPQHeap capacity must be between 1 and 64");
+
+public:
+    /**
+     * Creates a new, empty priority queue that orders elements using compare.
+     */
+    explicit StaticPQHeap(Compare compare = Compare());
+
+    /**
+     * Destroys the elements still in the queue.
+     */
+    ~StaticPQHeap();
+
+    /**
+     * Adds a new element into the queue. If the queue already holds Capacity
+     * elements, this function calls error(). This operation runs in time
+     * O(log n).
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Removes and returns the frontmost element. If the priority queue is
+     * empty, this function calls error(). This operation runs in time
+     * O(log n).
+     */
+    T dequeue();
+
+    /**
+     * Removes the n frontmost elements and writes them, frontmost first, to
+     * out, just like BasicPQHeap::dequeueMany. If n is negative or more than
+     * size(), this function calls error().
+     */
+    template <typename OutputIt>
+    OutputIt dequeueMany(int n, OutputIt out);
+
+    /**
+     * Removes the frontmost element and adds element in its place with a
+     * single percolate-down, returning the removed element. If the priority
+     * queue is empty, this function calls error().
+     */
+    T replaceTop(const T& element);
+    T replaceTop(T&& element);
+
+    /**
+     * Returns, but does not remove, the frontmost element. If the priority
+     * queue is empty, this function calls error().
+     */
+    const T& peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns whether this priority queue holds Capacity elements.
+     */
+    bool isFull() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Returns Capacity, the most elements the queue can hold.
+     */
+    static constexpr int capacity() {
+        return Capacity;
+    }
+
+    /**
+     * Removes all elements from the priority queue.
+     */
+    void clear();
+
+    /*
+     * Confirms that every element is no more urgent than its parent. Raises an
+     * error if a problem is found. Intended solely for testing.
+     */
+    void debugConfirmInternalArray() const;
+
+private:
+    /* Levels in a heap of Capacity elements, which bounds every percolation loop below. */
+    static constexpr int DEPTH = Capacity >= 32 ? 6 + (Capacity >= 64)
+                               : Capacity >= 8 ? 4 + (Capacity >= 16)
+                               : Capacity >= 2 ? 2 + (Capacity >= 4) : 1;
+
+    T* slots();                 // the inline storage as an array; only the first _numFilled are constructed
+    const T* slots() const;
+    void percolateUp(int hole, T&& element);   // moves the hole up past less urgent parents, then fills it
+    void percolateDown(int hole, T&& element); // moves the hole down past more urgent children, then fills it
+
+    alignas(T) unsigned char _storage[Capacity * sizeof(T)];
+    int _numFilled;
+    Compare _compare;           // compare(a, b) is true when a is more urgent than b
+
+    DISALLOW_COPYING_OF(StaticPQHeap);
+};
+
+
+/* * * * * * Implementation Below This Point * * * * * */
+
+template <int Capacity, typename T, typename Compare>
+StaticPQHeap<Capacity, T, Compare>::StaticPQHeap(Compare compare) : _numFilled(0), _compare(std::move(compare)) {}
+
+template <int Capacity, typename T, typename Compare>
+StaticPQHeap<Capacity, T, Compare>::~StaticPQHeap() {
+    clear();
+}
+
+template <int Capacity, typename T, typename Compare>
+T* StaticPQHeap<Capacity, T, Compare>::slots() {
+    return std::launder(reinterpret_cast<T*>(_storage));
+}
+
+template <int Capacity, typename T, typename Compare>
+const T* StaticPQHeap<Capacity, T, Compare>::slots() const {
+    return std::launder(reinterpret_cast<const T*>(_storage));
+}
+
+template <int Capacity, typename T, typename Compare>
+void StaticPQHeap<Capacity, T, Compare>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+/*
+ * The new slot at the end holds no object yet, so it is move-constructed from element if element stays
+ * there, and otherwise from the parent element displaces, with percolateUp carrying on from the parent's
+ * slot. No T is ever default-constructed.
+ */
+template <int Capacity, typename T, typename Compare>
+void StaticPQHeap<Capacity, T, Compare>::enqueue(T&& element) {
+    if (isFull()) {
+        error("Cannot enqueue because StaticPQHeap is full at " + integerToString(Capacity) + " elements!");
+    }
+    T* elements = slots();
+    int hole = _numFilled;
+    int parent = (hole - 1) / 2;
+    if (hole == 0 || !_compare(element, elements[parent])) {
+        ::new (static_cast<void*>(elements + hole)) T(std::move(element));
+        _numFilled++;
+        return;
+    }
+    ::new (static_cast<void*>(elements + hole)) T(std::move(elements[parent]));
+    _numFilled++;
+    percolateUp(parent, std::move(element));
+}
+
+template <int Capacity, typename T, typename Compare>
+T StaticPQHeap<Capacity, T, Compare>::dequeue() {
+    if (isEmpty()) {
+        error("Cannot dequeue because StaticPQHeap is empty!");
+    }
+    T* elements = slots();
+    T result = std::move(elements[0]);
+    _numFilled--;
+    if (_numFilled > 0) {
+        percolateDown(0, std::move(elements[_numFilled]));
+    }
+    std::destroy_at(elements + _numFilled);
+    return result;
+}
+
+template <int Capacity, typename T, typename Compare>
+template <typename OutputIt>
+OutputIt StaticPQHeap<Capacity, T, Compare>::dequeueMany(int n, OutputIt out) {
+    if (n < 0 || n > size()) {
+        error("Cannot dequeueMany " + integerToString(n) + " elements from StaticPQHeap of size "
+              + integerToString(size()) + "!");
+    }
+    T* elements = slots();
+    for (int i = 0; i < n; i++) {
+        *out = std::move(elements[0]);
+        ++out;
+        _numFilled--;
+        if (_numFilled > 0) {
+            percolateDown(0, std::move(elements[_numFilled]));
+        }
+        std::destroy_at(elements + _numFilled);
+    }
+    return out;
+}
+
+template <int Capacity, typename T, typename Compare>
+T StaticPQHeap<Capacity, T, Compare>::replaceTop(const T& element) {
+    return replaceTop(T(element));
+}
+
+template <int Capacity, typename T, typename Compare>
+T StaticPQHeap<Capacity, T, Compare>::replaceTop(T&& element) {
+    if (isEmpty()) {
+        error("Cannot replaceTop because StaticPQHeap is empty!");
+    }
+    T replaced = std::move(slots()[0]);
+    percolateDown(0, std::move(element));
+    return replaced;
+}
+
+template <int Capacity, typename T, typename Compare>
+const T& StaticPQHeap<Capacity, T, Compare>::peek() const {
+    if (isEmpty()) {
+        error("Cannot peek because StaticPQHeap is empty!");
+    }
+    return slots()[0];
+}
+
+template <int Capacity, typename T, typename Compare>
+bool StaticPQHeap<Capacity, T, Compare>::isEmpty() const {
+    return _numFilled == 0;
+}
+
+template <int Capacity, typename T, typename Compare>
+bool StaticPQHeap<Capacity, T, Compare>::isFull() const {
+    return _numFilled == Capacity;
+}
+
+template <int Capacity, typename T, typename Compare>
+int StaticPQHeap<Capacity, T, Compare>::size() const {
+    return _numFilled;
+}
+
+template <int Capacity, typename T, typename Compare>
+void StaticPQHeap<Capacity, T, Compare>::clear() {
+    std::destroy(slots(), slots() + _numFilled);
+    _numFilled = 0;
+}
+
+template <int Capacity, typename T, typename Compare>
+void StaticPQHeap<Capacity, T, Compare>::debugConfirmInternalArray() const {
+    const T* elements = slots();
+    for (int i = 1; i < _numFilled; i++) {
+        if (_compare(elements[i], elements[(i - 1) / 2])) {
+            error("StaticPQHeap element " + integerToString(i) + " is more urgent than its parent!");
+        }
+    }
+}
+
+/*
+ * A hole at index i is on level floor(log2(i + 1)), so it can rise at most DEPTH - 1 times. Counting the
+ * steps against that constant instead of testing for the root gives a loop of known length.
+ */
+template <int Capacity, typename T, typename Compare>
+void StaticPQHeap<Capacity, T, Compare>::percolateUp(int hole, T&& element) {
+    T* elements = slots();
+    for (int step = 1; step < DEPTH && hole > 0; step++) {
+        int parent = (hole - 1) / 2;
+        if (!_compare(element, elements[parent])) {
+            break;
+        }
+        elements[hole] = std::move(elements[parent]);
+        hole = parent;
+    }
+    elements[hole] = std::move(element);
+}
+
+/*
+ * As in BasicPQHeap, the more urgent child moves up into the hole while it is more urgent than element,
+ * for at most DEPTH - 1 levels.
+ */
+template <int Capacity, typename T, typename Compare>
+void StaticPQHeap<Capacity, T, Compare>::percolateDown(int hole, T&& element) {
+    T* elements = slots();
+    for (int step = 1; step < DEPTH; step++) {
+        int child = 2 * hole + 1;
+        if (child >= _numFilled) {
+            break;
+        }
+        if (child + 1 < _numFilled && _compare(elements[child + 1], elements[child])) {
+            child++;
+        }
+        if (!_compare(elements[child], element)) {
+            break;
+        }
+        elements[hole] = std::move(elements[child]);
+        hole = child;
+    }
+    elements[hole] = std::move(element);
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "datapoint.h"
+#include "datapointstream.h"
+#include "vector.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Helpers shared by the test sections of several files: loops that drive any
+ * priority queue the same way in the time trials, and scratch files of
+ * DataPoints for the readers that work on files.
+ */
+
+/* Whether Queue removes its frontmost element with dequeueMin rather than dequeue, as a double-ended
+ * queue such as MinMaxHeap does. */
+template <typename Queue, typename = void>
+struct HasDequeueMin : std::false_type {};
+
+template <typename Queue>
+struct HasDequeueMin<Queue, std::void_t<decltype(std::declval<Queue&>().dequeueMin())>> : std::true_type {};
+
+/**
+ * Removes the frontmost element of pq and throws it away, calling dequeueMin
+ * on a queue that has one and dequeue otherwise.
+ */
+template <typename Queue>
+void dequeueFront(Queue& pq) {
+    if constexpr (HasDequeueMin<Queue>::value) {
+        pq.dequeueMin();
+    } else {
+        pq.dequeue();
+    }
+}
+
+/**
+ * Enqueues every element of input in order. If dequeueEvery is positive, the
+ * frontmost element is also dequeued after every dequeueEvery-th enqueue, for
+ * a queue that keeps growing under a trickle of removals.
+ */
+template <typename Queue, typename T>
+void enqueueEach(Queue& pq, const Vector<T>& input, int dequeueEvery = 0) {
+    int enqueued = 0;
+    for (const T& elem : input) {
+        pq.enqueue(elem);
+        if (dequeueEvery > 0 && ++enqueued % dequeueEvery == 0) {
+            dequeueFront(pq);
+        }
+    }
+}
+
+/**
+ * Dequeues from pq until it is empty.
+ */
+template <typename Queue>
+void drain(Queue& pq) {
+    while (!pq.isEmpty()) {
+        dequeueFront(pq);
+    }
+}
+
+/**
+ * Enqueues every element of input and then drains the queue again, rounds
+ * times over.
+ */
+template <typename Queue, typename T>
+void fillThenDrain(Queue& pq, const Vector<T>& input, int rounds = 1) {
+    for (int r = 0; r < rounds; r++) {
+        enqueueEach(pq, input);
+        drain(pq);
+    }
+}
+
+/**
+ * Writes points to a file in the system temporary directory, in the binary
+ * format (named stem.bin) or as text with one point per line (stem.txt), and
+ * returns its path. An existing file of that name is overwritten; the caller
+ * removes it when done.
+ */
+inline std::string writeScratchFile(const std::string& stem, const Vector<DataPoint>& points, bool binary) {
+    std::string name = stem + (binary ? ".bin" : ".txt");
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (binary) {
+        DataPointWriter writer(out);
+        for (const DataPoint& pt : points) {
+            writer.write(pt);
+        }
+    } else {
+        for (const DataPoint& pt : points) {
+            out << pt << '\n';
+        }
+    }
+    return path;
+}
@@ -0,0 +1,349 @@
+/*
+ * This file, tieredpqarray, implements the TieredPQArray class declared in tieredpqarray.h, followed by its
+ * test cases and time trials against PQArray and PQHeap.
+ */
+#include "tieredpqarray.h"
+#include "error.h"
+#include "pqarray.h"
+#include "pqheap.h"
+#include "random.h"
+#include "strlib.h"
+#include "testsupport.h"
+#include "SimpleTest.h"
+#include <algorithm>
+using namespace std;
+
+TieredPQArray::Block::Block(int capacity) : slots(capacity), head(0), count(0) {}
+
+DataPoint& TieredPQArray::Block::operator[](int i) {
+    return slots[(head + i) & (int(slots.size()) - 1)];
+}
+
+const DataPoint& TieredPQArray::Block::operator[](int i) const {
+    return slots[(head + i) & (int(slots.size()) - 1)];
+}
+
+bool TieredPQArray::Block::isFull() const {
+    return count == int(slots.size());
+}
+
+/*
+ * Opening a slot at pos means moving either the pos elements in front of it one step toward the head or
+ * the count - pos behind it one step toward the tail; the buffer is circular, so either way works and
+ * the shorter one is taken. Unless the elements to move wrap around the end of the buffer, they are moved
+ * as one contiguous range, which runs several times faster than stepping through them by index.
+ */
+void TieredPQArray::Block::insert(int pos, DataPoint&& element) {
+    Block& self = *this;
+    DataPoint* base = slots.data();
+    int mask = int(slots.size()) - 1;
+    if (pos < count - pos) {
+        if (head >= 1 && head + pos <= mask + 1) {
+            std::move(base + head, base + head + pos, base + head - 1);
+            head--;
+        } else {
+            head = (head - 1) & mask;
+            for (int i = 0; i < pos; i++) {
+                self[i] = std::move(self[i + 1]);
+            }
+        }
+    } else {
+        int from = (head + pos) & mask;
+        int end = (head + count) & mask;
+        if (from <= end) {
+            std::move_backward(base + from, base + end, base + end + 1);
+        } else {
+            for (int i = count; i > pos; i--) {
+                self[i] = std::move(self[i - 1]);
+            }
+        }
+    }
+    self[pos] = std::move(element);
+    count++;
+}
+
+void TieredPQArray::Block::pushFront(DataPoint&& element) {
+    head = (head - 1) & (int(slots.size()) - 1);
+    (*this)[0] = std::move(element);
+    count++;
+}
+
+void TieredPQArray::Block::pushBack(DataPoint&& element) {
+    (*this)[count] = std::move(element);
+    count++;
+}
+
+/*
+ * In a full circular buffer the slot before the head is the last slot, so swapping carry into the last
+ * slot and stepping the head back turns that slot into the front: a pushFront and a popBack touching
+ * only one slot.
+ */
+void TieredPQArray::Block::rotateIn(DataPoint& carry) {
+    std::swap(carry, (*this)[count - 1]);
+    head = (head - 1) & (int(slots.size()) - 1);
+}
+
+DataPoint TieredPQArray::Block::popFront() {
+    DataPoint front = std::move((*this)[0]);
+    head = (head + 1) & (int(slots.size()) - 1);
+    count--;
+    return front;
+}
+
+DataPoint TieredPQArray::Block::popBack() {
+    count--;
+    return std::move((*this)[count]);
+}
+
+TieredPQArray::TieredPQArray() : _blockSize(MIN_BLOCK_SIZE), _size(0) {}
+
+/*
+ * Only the last block can be missing an element past its end, so it is the only one an element is ever
+ * appended to. Any other full block makes room by handing its last element to the front of the next
+ * block, which, if full itself, does the same, until a carry lands in the last block or a new one.
+ */
+void TieredPQArray::enqueue(DataPoint element) {
+    if (_blocks.empty()) {
+        _blocks.emplace_back(_blockSize);
+    }
+    int index = findBlock(element.priority);
+    Block& block = _blocks[index];
+
+    // the first slot not more urgent than element, which puts element ahead of any equal ones
+    int lo = 0, hi = block.count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (block[mid].priority < element.priority) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (!block.isFull()) {
+        block.insert(lo, std::move(element));
+    } else if (lo == block.count) {
+        _blocks.emplace_back(_blockSize);
+        _blocks.back().pushBack(std::move(element));
+    } else {
+        DataPoint carry = block.popBack();
+        block.insert(lo, std::move(element));
+        for (int next = index + 1; ; next++) {
+            if (next == int(_blocks.size())) {
+                _blocks.emplace_back(_blockSize);
+            }
+            Block& following = _blocks[next];
+            if (!following.isFull()) {
+                following.pushFront(std::move(carry));
+                break;
+            }
+            following.rotateIn(carry);
+        }
+    }
+    _size++;
+
+    if (int(_blocks.size()) > _blockSize / BLOCK_SIZE_RATIO) {
+        regroup(2 * _blockSize);
+    }
+}
+
+/*
+ * Blocks are dropped as soon as they run empty, so every block has a last element to compare.
+ */
+int TieredPQArray::findBlock(double priority) const {
+    int lo = 0, hi = int(_blocks.size()) - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        const Block& block = _blocks[mid];
+        if (block[block.count - 1].priority < priority) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+ * The old blocks are freed one by one as they are emptied, so the queue never holds much more than two
+ * copies' worth of slots at once.
+ */
+void TieredPQArray::regroup(int blockSize) {
+    deque<Block> regrouped;
+    while (!_blocks.empty()) {
+        Block& block = _blocks.front();
+        for (int i = 0; i < block.count; i++) {
+            if (regrouped.empty() || regrouped.back().isFull()) {
+                regrouped.emplace_back(blockSize);
+            }
+            regrouped.back().pushBack(std::move(block[i]));
+        }
+        _blocks.pop_front();
+    }
+    _blocks.swap(regrouped);
+    _blockSize = blockSize;
+}
+
+DataPoint TieredPQArray::dequeue() {
+    if (isEmpty()) {
+        error("Cannot dequeue because TieredPQArray is empty!");
+    }
+    DataPoint front = _blocks.front().popFront();
+    if (_blocks.front().count == 0) {
+        _blocks.pop_front();
+    }
+    _size--;
+    return front;
+}
+
+const DataPoint& TieredPQArray::peek() const {
+    if (isEmpty()) {
+        error("Cannot peek because TieredPQArray is empty!");
+    }
+    return _blocks.front()[0];
+}
+
+/*
+ * Only the first block can be short at its front, so past it the rank alone says which block and slot
+ * the element is in.
+ */
+const DataPoint& TieredPQArray::at(int rank) const {
+    if (rank < 0 || rank >= _size) {
+        error("TieredPQArray rank " + integerToString(rank) + " is out of range!");
+    }
+    const Block& first = _blocks.front();
+    if (rank < first.count) {
+        return first[rank];
+    }
+    rank -= first.count;
+    return _blocks[1 + rank / _blockSize][rank % _blockSize];
+}
+
+bool TieredPQArray::isEmpty() const {
+    return _size == 0;
+}
+
+int TieredPQArray::size() const {
+    return _size;
+}
+
+void TieredPQArray::clear() {
+    _blocks.clear();
+    _blockSize = MIN_BLOCK_SIZE;
+    _size = 0;
+}
+
+int TieredPQArray::blockSize() const {
+    return _blockSize;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("TieredPQArray: example from PQArray writeup, newest first among equals") {
+    TieredPQArray pq;
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+    EXPECT_ERROR(pq.at(0));
+
+    pq.enqueue({"Zoe", -3});
+    pq.enqueue({"Elmo", 10});
+    pq.enqueue({"Bert", 6});
+    pq.enqueue({"Kermit", 5});
+    pq.enqueue({"Oscar", 6});
+    EXPECT_EQUAL(pq.size(), 5);
+    EXPECT_EQUAL(pq.peek(), {"Zoe", -3});
+    EXPECT_EQUAL(pq.at(2), {"Oscar", 6});
+    EXPECT_EQUAL(pq.at(4), {"Elmo", 10});
+    EXPECT_ERROR(pq.at(5));
+    EXPECT_ERROR(pq.at(-1));
+
+    EXPECT_EQUAL(pq.dequeue(), {"Zoe", -3});
+    EXPECT_EQUAL(pq.dequeue(), {"Kermit", 5});
+    EXPECT_EQUAL(pq.dequeue(), {"Oscar", 6});
+    EXPECT_EQUAL(pq.dequeue(), {"Bert", 6});
+    EXPECT_EQUAL(pq.dequeue(), {"Elmo", 10});
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("TieredPQArray: stress test against PQHeap as the blocks grow") {
+    setRandomSeed(22);
+    TieredPQArray pq;
+    PQHeap reference;
+    for (int i = 0; i < 30000; i++) {
+        if (randomChance(0.7) || reference.isEmpty()) {
+            DataPoint elem = {"label " + integerToString(i), double(randomInteger(0, 5000))};
+            reference.enqueue(elem);
+            pq.enqueue(elem);
+        } else {
+            EXPECT_EQUAL(pq.dequeue().priority, reference.dequeue().priority);
+        }
+        if (i % 5000 == 0 && !pq.isEmpty()) {
+            for (int rank = 1; rank < pq.size(); rank++) {
+                EXPECT(pq.at(rank - 1).priority <= pq.at(rank).priority);
+            }
+        }
+    }
+    EXPECT_EQUAL(pq.size(), reference.size());
+    EXPECT(pq.blockSize() > 32);                                // regrouped at least once
+    EXPECT(pq.blockSize() * pq.blockSize() >= 16 * pq.size());
+    while (!reference.isEmpty()) {
+        EXPECT_EQUAL(pq.peek().priority, reference.peek().priority);
+        EXPECT_EQUAL(pq.dequeue().priority, reference.dequeue().priority);
+    }
+    EXPECT(pq.isEmpty());
+    pq.clear();
+    EXPECT_EQUAL(pq.blockSize(), 32);
+}
+
+/* The single sorted array TieredPQArray splits into blocks. PQArray is no longer one past HEAP_CROSSOVER
+ * elements, so this is the baseline for the cost of shifting: each enqueue finds its slot with upper_bound
+ * and inserts there, moving everything after it, and the most urgent element is kept at the back. */
+class SortedVectorQueue {
+public:
+    void enqueue(const DataPoint& elem) {
+        auto lessUrgent = [](double priority, const DataPoint& pt) {
+            return priority > pt.priority;
+        };
+        auto slot = upper_bound(_elements.begin(), _elements.end(), elem.priority, lessUrgent);
+        _elements.insert(int(slot - _elements.begin()), elem);
+    }
+
+    DataPoint dequeue() {
+        DataPoint front = std::move(_elements[_elements.size() - 1]);
+        _elements.remove(_elements.size() - 1);
+        return front;
+    }
+
+    bool isEmpty() const {
+        return _elements.isEmpty();
+    }
+
+private:
+    Vector<DataPoint> _elements;    // sorted from least to most urgent
+};
+
+STUDENT_TEST("TieredPQArray: time enqueue and dequeue against a sorted Vector, PQArray and PQHeap") {
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({"", randomReal(0, 10)});
+        }
+        /* Every sorted insert shifts half the array on average, so the baseline stops at 10^5. */
+        if (n <= 100000) {
+            SortedVectorQueue sorted;
+            TIME_OPERATION(n, enqueueEach(sorted, input));
+            TIME_OPERATION(n, drain(sorted));
+        }
+        TieredPQArray tiered;
+        PQArray array;
+        PQHeap heap;
+        TIME_OPERATION(n, enqueueEach(tiered, input));
+        TIME_OPERATION(n, enqueueEach(array, input));
+        TIME_OPERATION(n, enqueueEach(heap, input));
+        TIME_OPERATION(n, drain(tiered));
+        TIME_OPERATION(n, drain(array));
+        TIME_OPERATION(n, drain(heap));
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "MemoryUtils.h"
+#include "datapoint.h"
+#include <deque>
+#include <vector>
+
+/**
+ * Priority queue of DataPoints kept in sorted order, like PQArray, but split
+ * into blocks so that an enqueue does not have to shift the whole array.
+ *
+ * The elements are kept frontmost first in a sequence of blocks, each a
+ * circular buffer of the same power-of-two size B. Every block but the first
+ * and the last is full. An enqueue finds its block by binary search over the
+ * blocks' last elements, shifts at most half of that one block to open a slot,
+ * and, if the block was full, carries its last element into the front of the
+ * next block, and so on to the end: a carry into a circular buffer is O(1), so
+ * the whole enqueue costs O(B + n / B). B doubles whenever there come to be
+ * more than B / 16 blocks, which keeps it near 4 sqrt(n) and enqueue in
+ * O(sqrt n).
+ *
+ * What a sorted array is good at is kept: the front is the first element of
+ * the first block, so peek and dequeue run in time O(1), and because the inner
+ * blocks are full, the element of any rank is found in O(1) without a search,
+ * so the queue can be walked in priority order with at().
+ *
+ * Elements of equal priority are dequeued newest first, as for PQArray.
+ */
+class TieredPQArray {
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    TieredPQArray();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time
+     * O(sqrt n).
+     */
+    void enqueue(DataPoint element);
+
+    /**
+     * Removes and returns the frontmost element. If the priority queue is
+     * empty, this function calls error(). This operation runs in time O(1).
+     */
+    DataPoint dequeue();
+
+    /**
+     * Returns, but does not remove, the frontmost element. If the priority
+     * queue is empty, this function calls error().
+     */
+    const DataPoint& peek() const;
+
+    /**
+     * Returns the element that would be dequeued rank-th, counting from 0 for
+     * the frontmost. If rank is not in [0, size()), this function calls
+     * error(). This operation runs in time O(1).
+     */
+    const DataPoint& at(int rank) const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements and goes back to the smallest block size.
+     */
+    void clear();
+
+    /**
+     * Returns the number of elements each block holds.
+     */
+    int blockSize() const;
+
+private:
+    /* Blocks start out this size; it is doubled from there as the queue grows. */
+    static const int MIN_BLOCK_SIZE = 32;
+
+    /* The block size is doubled once there are more than blockSize / BLOCK_SIZE_RATIO blocks. A carry
+     * lands in another block's memory and cost about as much as moving 16 neighbouring elements during
+     * a shift, so fewer, larger blocks than the balanced sqrt(n) came out fastest. */
+    static const int BLOCK_SIZE_RATIO = 16;
+
+    /* A circular buffer of a fixed power-of-two number of slots. Element i sits in
+     * slots[(head + i) & (slots.size() - 1)]. */
+    struct Block {
+        explicit Block(int capacity);
+        DataPoint& operator[](int i);
+        const DataPoint& operator[](int i) const;
+        bool isFull() const;
+        void insert(int pos, DataPoint&& element); // shifts whichever side of pos is shorter
+        void pushFront(DataPoint&& element);
+        void rotateIn(DataPoint& carry);           // a full block's pushFront(carry), handing back its last element in carry
+        void pushBack(DataPoint&& element);
+        DataPoint popFront();
+        DataPoint popBack();
+
+        std::vector<DataPoint> slots;
+        int head;   // slot of element 0
+        int count;  // elements in use
+    };
+
+    int findBlock(double priority) const;  // first block whose last element is not more urgent, else the last
+    void regroup(int blockSize);           // moves every element into fresh blocks of blockSize
+
+    std::deque<Block> _blocks;  // frontmost block first; all but the first and last are full
+    int _blockSize;             // slots in every block
+    int _size;                  // elements in all blocks
+
+    DISALLOW_COPYING_OF(TieredPQArray);
+};